@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+
+namespace micro_mouse {
+
+/*
+ * Optional MazeControlAPI instrumentation, built with -DRWA4_INSTRUMENT=ON.
+ * maze_api.cpp then counts every command by type, including the commands
+ * inside posted steps, times the commands that wait for a reply, each posted
+ * step as one round trip, and prints a summary with latency histograms on
+ * stderr at exit and whenever was_reset() reports a new reset. The backends
+ * report the protocol bytes through the two hooks below. Without the option,
+ * the hooks are empty inline functions and the instrumentation compiles to
+ * nothing.
+ */
+
+#ifdef RWA4_INSTRUMENT
+/// Count bytes written to the simulator
+void instrument_bytes_written(std::size_t bytes) noexcept;
+/// Count bytes read from the simulator
+void instrument_bytes_read(std::size_t bytes) noexcept;
+#else
+inline void instrument_bytes_written(std::size_t) noexcept {}
+inline void instrument_bytes_read(std::size_t) noexcept {}
+#endif
+
+} // namespace micro_mouse
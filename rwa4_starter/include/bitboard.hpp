@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+
+namespace micro_mouse {
+
+/**
+ * @brief 256-bit set of cells of a 16x16 maze, bit i for cell i = 16 * y + x
+ *
+ * Shifting by 1 moves every cell one step east (or west), shifting by 16 one
+ * step north (or south); the caller masks out moves through walls.
+ */
+struct Bitboard256 {
+  std::uint64_t words[4]{0, 0, 0, 0};
+
+  [[nodiscard]] constexpr bool any() const noexcept {
+    return (words[0] | words[1] | words[2] | words[3]) != 0;
+  }
+
+  [[nodiscard]] constexpr bool test(int cell) const noexcept {
+    return (words[cell >> 6] >> (cell & 63)) & 1U;
+  }
+
+  constexpr void set(int cell) noexcept {
+    words[cell >> 6] |= std::uint64_t{1} << (cell & 63);
+  }
+
+  /**
+   * @brief Move every cell towards higher indices by @p n (1 <= n < 64)
+   */
+  [[nodiscard]] constexpr Bitboard256 shifted_up(int n) const noexcept {
+    return {{words[0] << n, (words[1] << n) | (words[0] >> (64 - n)),
+             (words[2] << n) | (words[1] >> (64 - n)), (words[3] << n) | (words[2] >> (64 - n))}};
+  }
+
+  /**
+   * @brief Move every cell towards lower indices by @p n (1 <= n < 64)
+   */
+  [[nodiscard]] constexpr Bitboard256 shifted_down(int n) const noexcept {
+    return {{(words[0] >> n) | (words[1] << (64 - n)), (words[1] >> n) | (words[2] << (64 - n)),
+             (words[2] >> n) | (words[3] << (64 - n)), words[3] >> n}};
+  }
+
+  friend constexpr Bitboard256 operator&(const Bitboard256 &a, const Bitboard256 &b) noexcept {
+    return {{a.words[0] & b.words[0], a.words[1] & b.words[1], a.words[2] & b.words[2], a.words[3] & b.words[3]}};
+  }
+  friend constexpr Bitboard256 operator|(const Bitboard256 &a, const Bitboard256 &b) noexcept {
+    return {{a.words[0] | b.words[0], a.words[1] | b.words[1], a.words[2] | b.words[2], a.words[3] | b.words[3]}};
+  }
+  friend constexpr Bitboard256 operator~(const Bitboard256 &a) noexcept {
+    return {{~a.words[0], ~a.words[1], ~a.words[2], ~a.words[3]}};
+  }
+
+  /**
+   * @brief Call @p visit with the index of each set cell, in increasing order
+   */
+  template <typename Visitor>
+  void for_each(Visitor visit) const {
+    for (int w = 0; w < 4; ++w) {
+      for (std::uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+        visit(64 * w + __builtin_ctzll(bits));
+      }
+    }
+  }
+}; // struct Bitboard256
+
+} // namespace micro_mouse
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "maze_map.hpp"
+#include "maze_types.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @struct Checkpoint
+ * @brief What a run has learned about the maze, as saved between runs
+ */
+struct Checkpoint {
+  std::uint64_t maze_id{0}; // fingerprint of the maze the map was learned in, 0 if unknown
+  MazeMap map;
+  std::vector<Cell> goals;              // goals of the distance field, at most FloodFillBase::kMaxGoals
+  std::vector<std::uint16_t> distances; // of each cell to each goal, goals.size() per cell
+};
+
+/**
+ * @brief Save the wall map and distance field to a binary checkpoint file
+ *
+ * Layout, little endian: the magic "RWA4CKPT", a 16-bit version, width,
+ * height and goal count, the 64-bit maze id, each goal as 16-bit x and y,
+ * the 4 wall planes of MazeMap as 64-bit words, the 16-bit distances and a
+ * 32-bit FNV-1a checksum of everything before it. A 16x16 maze with the
+ * four center goals takes 2220 bytes. The file is written next to @p path
+ * and renamed into place, so a reset in the middle of a save leaves the
+ * previous checkpoint intact.
+ * @param path Checkpoint file
+ * @param checkpoint Walls learned so far, the maze they belong to and their
+ * distance field
+ * @return false if the file could not be written, or if the distances do
+ * not fit the goals
+ */
+bool save_checkpoint(const std::string &path, const Checkpoint &checkpoint);
+
+/**
+ * @brief Load a checkpoint written by save_checkpoint()
+ * @param path Checkpoint file
+ * @param checkpoint Receives the map, maze id and distance field, untouched
+ * on failure
+ * @return false if the file is missing, truncated, corrupted or from
+ * another version
+ */
+bool load_checkpoint(const std::string &path, Checkpoint &checkpoint);
+
+} // namespace micro_mouse
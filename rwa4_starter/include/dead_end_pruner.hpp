@@ -0,0 +1,301 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "maze_map.hpp"
+#include "maze_types.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Cells of a MazeMap that no route between the terminals can use
+ *
+ * The terminals are the start, the goals and the cell of the mouse. Walls
+ * not observed yet count as open, as in the exploration field. A cell other
+ * than a terminal with at most one open side towards cells not blocked yet
+ * is a dead end: a path entering it would have to leave the way it came.
+ * Blocking it may turn its neighbour into a dead end in turn, so whole
+ * corridors and branches fold up. This is kept up to date incrementally:
+ * a new wall only re-examines its two cells, the mouse leaving a cell only
+ * that cell, and each blocked cell is visited a bounded number of times.
+ *
+ * rebuild() starts over and additionally blocks regions: a group of cells
+ * hanging off the rest of the maze by a single passage (a bridge) and holding
+ * no terminal, and the cells the mouse cannot reach at all. A depth-first
+ * search from the mouse finds the bridges, as in Tarjan's algorithm.
+ *
+ * Blocking is conservative for every route between terminals: shortest
+ * paths keep their length, so planners may skip the blocked cells, see
+ * BasicFloodFillPlanner::compute(). The blocked cells are a bit plane laid
+ * out like the planes of the map, bit i for cell i.
+ *
+ * W and H fix the dimensions at compile time, as for BasicMazeMap: the
+ * planes and the search scratch are then std::arrays, and the cell loops
+ * run to a constant.
+ */
+template <int W = kDynamic, int H = kDynamic>
+class BasicDeadEndPruner {
+public:
+  using Map = BasicMazeMap<W, H>;
+
+  /// true when the dimensions are compile-time constants
+  static constexpr bool kFixed = Map::kFixed;
+
+  /**
+   * @brief Create a pruner for a maze of the given size, nothing blocked
+   * @throw std::invalid_argument if the dimensions do not fit W and H
+   */
+  BasicDeadEndPruner(int width, int height);
+
+  /**
+   * @brief Forget every blocked cell and prune @p map from scratch
+   * @param map Walls known so far
+   * @param terminals Start and goal cells, never blocked
+   * @param mouse Cell of the mouse, never blocked
+   */
+  void rebuild(const Map &map, const std::vector<Cell> &terminals, const Cell &mouse);
+
+  /**
+   * @brief Re-examine the two cells of a wall found present
+   */
+  void wall_added(const Map &map, int x, int y, Direction direction);
+
+  /**
+   * @brief Follow the mouse to (x, y), re-examining the cell it left
+   */
+  void move_mouse(const Map &map, int x, int y);
+
+  [[nodiscard]] bool is_blocked(int x, int y) const noexcept { return test(blocked_, y * get_width() + x); }
+  /// Blocked cells as a bit plane, see BasicMazeMap::get_plane()
+  [[nodiscard]] const std::uint64_t *get_blocked() const noexcept { return blocked_.data(); }
+  [[nodiscard]] int get_blocked_count() const noexcept { return blocked_count_; }
+
+  [[nodiscard]] int get_width() const noexcept {
+    if constexpr (kFixed) {
+      return W;
+    } else {
+      return width_;
+    }
+  }
+  [[nodiscard]] int get_cell_count() const noexcept {
+    if constexpr (kFixed) {
+      return W * H;
+    } else {
+      return width_ * height_;
+    }
+  }
+
+private:
+  static constexpr std::size_t kFixedWords = kFixed ? (static_cast<std::size_t>(W * H) + 63) / 64 : 0;
+  using Plane = std::conditional_t<kFixed, std::array<std::uint64_t, kFixedWords>, std::vector<std::uint64_t>>;
+
+  // Block the cell if it is a dead end, then follow the corridor it opens on
+  void examine(const Map &map, int cell);
+  // Block the regions hanging off bridges, and the cells the mouse cannot reach
+  void prune_regions(const Map &map);
+  void block(int cell) noexcept {
+    blocked_[static_cast<std::size_t>(cell >> 6)] |= std::uint64_t{1} << (cell & 63);
+    ++blocked_count_;
+  }
+  [[nodiscard]] static bool test(const Plane &plane, int cell) noexcept {
+    return (plane[static_cast<std::size_t>(cell >> 6)] >> (cell & 63)) & 1U;
+  }
+  // Write the cells not blocked that @p cell opens on to @p neighbours, in
+  // Direction order, and return their count
+  int open_neighbours(const Map &map, int cell, int (&neighbours)[4]) const noexcept;
+
+  int width_;
+  int height_;
+  Plane blocked_{};
+  Plane terminals_{};
+  int blocked_count_{0};
+  int mouse_{0};
+  // region search scratch, one entry per cell, kept to avoid reallocating
+  CellArray<int, W, H> order_{};
+  CellArray<int, W, H> low_{};
+  CellArray<int, W, H> parent_{};
+  CellArray<int, W, H> terminals_behind_{};
+  CellArray<int, W, H> visited_{};
+  CellArray<int, W, H> stack_{};
+  CellArray<std::uint8_t, W, H> dead_{};
+}; // class BasicDeadEndPruner
+
+/// Pruner for maps whose dimensions are known at run time
+using DeadEndPruner = BasicDeadEndPruner<>;
+
+template <int W, int H>
+BasicDeadEndPruner<W, H>::BasicDeadEndPruner(int width, int height) : width_{width}, height_{height} {
+  if (width <= 0 || height <= 0) {
+    throw std::invalid_argument("maze dimensions must be positive");
+  }
+  if constexpr (kFixed) {
+    if (width != W || height != H) {
+      throw std::invalid_argument("maze dimensions do not match the pruner type");
+    }
+  } else {
+    const std::size_t cells = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    blocked_.assign((cells + 63) / 64, 0);
+    terminals_.assign(blocked_.size(), 0);
+    order_.resize(cells);
+    low_.resize(cells);
+    parent_.resize(cells);
+    terminals_behind_.resize(cells);
+    visited_.resize(cells);
+    stack_.resize(cells);
+    dead_.resize(cells);
+  }
+}
+
+template <int W, int H>
+int BasicDeadEndPruner<W, H>::open_neighbours(const Map &map, int cell, int (&neighbours)[4]) const noexcept {
+  const int x = cell % get_width();
+  const int y = cell / get_width();
+  int count = 0;
+  for (int d = 0; d < 4; ++d) {
+    const auto direction = static_cast<Direction>(d);
+    if (map.has_wall(x, y, direction)) {
+      continue;
+    }
+    const int neighbour = map.index(x + dx(direction), y + dy(direction));
+    if (!test(blocked_, neighbour)) {
+      neighbours[count++] = neighbour;
+    }
+  }
+  return count;
+}
+
+template <int W, int H>
+void BasicDeadEndPruner<W, H>::examine(const Map &map, int cell) {
+  int neighbours[4];
+  while (!test(blocked_, cell) && !test(terminals_, cell) && cell != mouse_) {
+    const int count = open_neighbours(map, cell, neighbours);
+    if (count > 1) {
+      return;
+    }
+    block(cell);
+    if (count == 0) {
+      return;
+    }
+    cell = neighbours[0];
+  }
+}
+
+template <int W, int H>
+void BasicDeadEndPruner<W, H>::wall_added(const Map &map, int x, int y, Direction direction) {
+  examine(map, map.index(x, y));
+  if (map.contains(x + dx(direction), y + dy(direction))) {
+    examine(map, map.index(x + dx(direction), y + dy(direction)));
+  }
+}
+
+template <int W, int H>
+void BasicDeadEndPruner<W, H>::move_mouse(const Map &map, int x, int y) {
+  const int left = mouse_;
+  mouse_ = map.index(x, y);
+  examine(map, left);
+}
+
+template <int W, int H>
+void BasicDeadEndPruner<W, H>::rebuild(const Map &map, const std::vector<Cell> &terminals, const Cell &mouse) {
+  std::fill(blocked_.begin(), blocked_.end(), 0);
+  std::fill(terminals_.begin(), terminals_.end(), 0);
+  blocked_count_ = 0;
+  for (const Cell &terminal : terminals) {
+    if (map.contains(terminal.x, terminal.y)) {
+      const int cell = map.index(terminal.x, terminal.y);
+      terminals_[static_cast<std::size_t>(cell >> 6)] |= std::uint64_t{1} << (cell & 63);
+    }
+  }
+  mouse_ = map.index(mouse.x, mouse.y);
+  for (int cell = 0; cell < get_cell_count(); ++cell) {
+    examine(map, cell);
+  }
+  prune_regions(map);
+  // the cell in front of a blocked region may be a dead end now
+  for (int cell = 0; cell < get_cell_count(); ++cell) {
+    examine(map, cell);
+  }
+}
+
+template <int W, int H>
+void BasicDeadEndPruner<W, H>::prune_regions(const Map &map) {
+  // Iterative depth-first search from the mouse over the cells left: order_
+  // is the visit order (-1 for unvisited cells), low_ the lowest order
+  // reachable from the subtree by one back edge. A tree edge to a child
+  // whose low_ exceeds the parent's order is a bridge, and the child's
+  // subtree is a region behind it. terminals_behind_ counts the terminals in
+  // the subtree of each cell.
+  const int cells = get_cell_count();
+  const auto at = [](auto &array, int cell) -> auto & { return array[static_cast<std::size_t>(cell)]; };
+  std::fill(order_.begin(), order_.end(), -1);
+  std::fill(terminals_behind_.begin(), terminals_behind_.end(), 0);
+  int visited = 0;
+  // stack entries: 5 * cell plus the next direction to try, 4 once done
+  int depth = 0;
+  const auto enter = [&](int cell, int parent) {
+    at(order_, cell) = visited;
+    at(low_, cell) = visited;
+    at(parent_, cell) = parent;
+    at(visited_, visited++) = cell;
+    at(stack_, depth++) = cell * 5;
+  };
+  enter(mouse_, -1);
+  while (depth > 0) {
+    int &top = at(stack_, depth - 1);
+    const int cell = top / 5;
+    const int d = top % 5;
+    if (d == 4) {
+      // subtree done: report to the parent
+      --depth;
+      at(terminals_behind_, cell) += (test(terminals_, cell) || cell == mouse_) ? 1 : 0;
+      const int parent = at(parent_, cell);
+      if (parent >= 0) {
+        at(low_, parent) = std::min(at(low_, parent), at(low_, cell));
+        at(terminals_behind_, parent) += at(terminals_behind_, cell);
+      }
+      continue;
+    }
+    ++top;
+    const auto direction = static_cast<Direction>(d);
+    const int x = cell % get_width();
+    const int y = cell / get_width();
+    if (map.has_wall(x, y, direction)) {
+      continue;
+    }
+    const int neighbour = map.index(x + dx(direction), y + dy(direction));
+    if (test(blocked_, neighbour) || neighbour == at(parent_, cell)) {
+      continue;
+    }
+    if (at(order_, neighbour) < 0) {
+      enter(neighbour, cell);
+    } else {
+      at(low_, cell) = std::min(at(low_, cell), at(order_, neighbour));
+    }
+  }
+
+  // in visit order, parents come before their children: a cell is dead if
+  // its parent is, or if it sits behind a bridge with no terminal
+  std::fill(dead_.begin(), dead_.end(), 0);
+  for (int i = 1; i < visited; ++i) {
+    const int cell = at(visited_, i);
+    const int parent = at(parent_, cell);
+    at(dead_, cell) = at(dead_, parent) || (at(low_, cell) > at(order_, parent) && at(terminals_behind_, cell) == 0);
+  }
+  for (int cell = 0; cell < cells; ++cell) {
+    const bool unreachable = at(order_, cell) < 0 && !test(terminals_, cell);
+    if (!test(blocked_, cell) && (at(dead_, cell) || unreachable)) {
+      block(cell);
+    }
+  }
+}
+
+// compiled once in dead_end_pruner.cpp
+extern template class BasicDeadEndPruner<kClassicSize, kClassicSize>;
+extern template class BasicDeadEndPruner<kDynamic, kDynamic>;
+
+} // namespace micro_mouse
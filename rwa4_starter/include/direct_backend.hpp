@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+
+#include "maze_backend.hpp"
+#include "maze_simulator.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Backend calling an in-process MazeSimulator directly
+ *
+ * Queries and moves are plain member function calls on the simulator: no
+ * text is formatted, flushed or parsed. Visualization commands have nothing
+ * to draw on and are dropped.
+ */
+class DirectBackend : public MazeBackend {
+public:
+  /**
+   * @brief Attach the backend to a simulator
+   * @param maze Simulator answering the calls, must outlive the backend
+   */
+  explicit DirectBackend(MazeSimulator &maze) : maze_{maze} {}
+
+  int get_maze_width() override { return maze_.get_width(); }
+  int get_maze_height() override { return maze_.get_height(); }
+  bool has_wall_front() override { return maze_.wall_front(); }
+  bool has_wall_right() override { return maze_.wall_right(); }
+  bool has_wall_left() override { return maze_.wall_left(); }
+  void move_forward(int distance) override;
+  void turn_right() override { maze_.turn_right(); }
+  void turn_left() override { maze_.turn_left(); }
+  void set_wall(int, int, char) override {}
+  void clear_wall(int, int, char) override {}
+  void set_color(int, int, char) override {}
+  void clear_color(int, int) override {}
+  void clear_all_color() override {}
+  void set_text(int, int, const std::string &) override {}
+  void clear_text(int, int) override {}
+  void clear_all_text() override {}
+  bool was_reset() override { return maze_.poll_reset(); }
+  void ack_reset() override { maze_.ack_reset(); }
+
+private:
+  MazeSimulator &maze_;
+}; // class DirectBackend
+
+} // namespace micro_mouse
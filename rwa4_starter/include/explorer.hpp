@@ -0,0 +1,303 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "checkpoint.hpp"
+#include "dead_end_pruner.hpp"
+#include "flood_fill.hpp"
+#include "maze_api.hpp"
+#include "maze_map.hpp"
+#include "maze_types.hpp"
+#include "path.hpp"
+#include "time_optimal_planner.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Flood-fill explorer driving the mouse through MazeControlAPI
+ *
+ * At every cell the explorer reads the left, front and right walls it has not
+ * observed yet, records them in its MazeMap, recomputes the distance field
+ * towards the goals and moves to the neighbour closest to the target goal.
+ * All the goals share one planner pass, so the target can be one particular
+ * goal or the nearest one.
+ *
+ * The exploration is a state machine stepped by StepCommands: begin() starts
+ * it, get_command() is the next step to send and answer() takes its replies
+ * and picks the step after it. The first step stays in place and reads the
+ * walls around the mouse; each following one turns, moves one cell and reads
+ * the unknown walls of the cell it leads to. explore() runs these steps
+ * through MazeControlAPI; a caller can also run them itself, e.g. one
+ * thread driving many explorers, see MouseController.
+ *
+ * In pipelined mode, each move goes out together with the wall queries of
+ * the cell it leads to, in one write. The field planned before the move
+ * counts the unknown walls of that cell as open, and stays exact unless the
+ * readings close a passage on a shortest path. While the simulator answers,
+ * the explorer computes the fields for the other readings it may get, as
+ * many as the round trip leaves time for; the actual readings then pick one
+ * of them, and the others are discarded. When none matches, the field is
+ * computed again as in the serial mode. The commands sent and the route
+ * taken are the same in both modes.
+ *
+ * With pruning, a BasicDeadEndPruner follows the map, and the planners skip
+ * the cells it blocks; the walls between the mouse and a blocked cell are
+ * not read either. The route is the same as without pruning.
+ *
+ * W and H fix the maze dimensions at compile time, as for BasicMazeMap.
+ * explorer.cpp compiles ClassicExplorer, for 16x16 competition mazes, and
+ * Explorer, which takes the dimensions at run time; pick the first when
+ * MazeControlAPI reports a 16x16 maze.
+ */
+template <int W = kDynamic, int H = kDynamic>
+class BasicExplorer {
+public:
+  using Map = BasicMazeMap<W, H>;
+  using Planner = BasicFloodFillPlanner<W, H>;
+
+  /**
+   * @brief Counters of the commands sent and the planning done
+   */
+  struct Stats {
+    std::uint64_t moves{0};
+    std::uint64_t turns{0};
+    std::uint64_t wall_queries{0};
+    std::uint64_t plans{0};
+    std::uint64_t plan_ns{0};      // time spent in the planners
+    std::uint64_t speculations{0}; // fields computed while a step was in flight
+    std::uint64_t discarded{0};    // speculative fields the readings disproved
+    std::uint64_t conflicts{0};    // speed runs stopped by a wall the map got wrong
+  };
+
+  /**
+   * @brief Create an explorer for a maze of the given size
+   * @param width Width of the maze in cells
+   * @param height Height of the maze in cells
+   * @throw std::invalid_argument if the dimensions do not fit W and H
+   */
+  BasicExplorer(int width, int height);
+
+  /**
+   * @brief Select a single goal cell
+   */
+  void set_goal(int x, int y) { set_goals({{x, y}}); }
+
+  /**
+   * @brief Select the goal cells, the center cells by default
+   * @param goals Goal cells, at most FloodFillPlanner::kMaxGoals
+   * @param target Index of the goal to reach, or -1 for whichever is nearest
+   */
+  void set_goals(const std::vector<Cell> &goals, int target = -1) {
+    goals_ = goals;
+    target_ = target;
+    seeded_ = false;
+  }
+
+  /**
+   * @brief Draw discovered walls and distances in the simulator
+   */
+  void set_visualize(bool enabled) noexcept;
+
+  /**
+   * @brief Stop explore() as soon as the simulator reports a reset
+   *
+   * Costs one MazeControlAPI::was_reset() query per move.
+   */
+  void set_watch_reset(bool enabled) noexcept { watch_reset_ = enabled; }
+
+  /**
+   * @brief Overlap planning with the moves in explore()
+   *
+   * Uses MazeControlAPI::post_step(), so it only pays off on backends with a
+   * round trip, such as the mms text pipe.
+   */
+  void set_pipelined(bool enabled) noexcept { pipelined_ = enabled; }
+
+  /**
+   * @brief Skip the dead ends and closed-off regions of the map in explore()
+   *
+   * The pruner is rebuilt at the start of every explore(), with the start and
+   * the goals as terminals, and kept up to date as walls are found. Off by
+   * default: the route cannot change, and the few wall readings saved have
+   * not paid for the pruning in planning time on the test corpora, see
+   * corpus_bench --prune.
+   */
+  void set_pruning(bool enabled) noexcept { pruning_ = enabled; }
+
+  /**
+   * @brief Move until the goal is reached
+   * @param max_moves Give up after this many moves
+   * @return true if the mouse stands on the goal; false if it is walled off,
+   * out of moves or, with set_watch_reset(), reset
+   */
+  bool explore(std::uint64_t max_moves = std::numeric_limits<std::uint64_t>::max());
+
+  /**
+   * @brief Start an exploration stepped by the caller
+   *
+   * Nothing is sent: the caller sends get_command() and hands the replies to
+   * answer() until is_exploring() turns false, then at_goal() tells whether
+   * the goal was reached. Only the visualization goes through MazeControlAPI.
+   * @param max_moves Give up after this many moves
+   */
+  void begin(std::uint64_t max_moves = std::numeric_limits<std::uint64_t>::max());
+
+  /**
+   * @brief Check whether a step is waiting to be sent
+   */
+  [[nodiscard]] bool is_exploring() const noexcept { return exploring_; }
+
+  /**
+   * @brief Step to send next, valid until answer()
+   */
+  [[nodiscard]] const StepCommand &get_command() const noexcept { return command_; }
+
+  /**
+   * @brief Hand over the replies to get_command() and pick the next step
+   * @throw std::logic_error if no exploration is in progress
+   */
+  void answer(const StepReply &reply);
+
+  /**
+   * @brief Check whether the mouse stands on the target goal
+   */
+  [[nodiscard]] bool at_goal() const noexcept;
+
+  /**
+   * @brief Run to the target goal along the fastest fully explored path
+   *
+   * Only passages observed to be open are used. The route minimizes the time
+   * estimated by the RunCostModel rather than the number of cells, and each
+   * straight is a single move_forward(n) as far as the passages have been
+   * read in this maze; the others are read one cell at a time before they
+   * are taken. If a reading disagrees with the map, which then came from
+   * another maze, the run stops there and the map falls back to the walls
+   * read in this maze.
+   * @return true if the mouse stands on the goal; false, without moving, if
+   * no explored path leads there, or where it stopped after a conflict
+   */
+  bool speed_run();
+
+  /**
+   * @brief Send the commands of a compiled path
+   *
+   * Passages not read in this maze yet are read, with the walls beside them,
+   * before they are taken, see speed_run().
+   * @return false, with the mouse where it stopped, as soon as a wall read
+   * disagrees with the map
+   */
+  bool execute(const std::vector<Segment> &segments);
+
+  /**
+   * @brief Adopt what an earlier run learned if it fits this maze
+   *
+   * The dimensions must match, and so must every wall read in this maze so
+   * far, the ones around the mouse first; those the map does not know are
+   * added. Few walls are read at the start, which does not tell two mazes
+   * apart: unless the map is trusted, speed_run() reads its passages before
+   * taking them. When the checkpoint holds the field of the current goals
+   * and no wall had to be added, the next explore() starts from that field
+   * instead of planning.
+   * @param checkpoint Map and distance field of an earlier run
+   * @param trusted true if the map is known to come from this maze, e.g. by
+   * a fingerprint of the maze, so that its walls count as read
+   * @return true if the checkpoint replaced the current map
+   */
+  bool restore(const Checkpoint &checkpoint, bool trusted = false);
+
+  /**
+   * @brief Take over the mouse from another controller
+   *
+   * Adopts the walls it observed and the pose it left the mouse in, without
+   * reading anything, e.g. after a WallFollower ran into a loop.
+   * @throw std::invalid_argument if the map does not fit this maze
+   */
+  void resume(const MazeMap &map, const Pose &pose);
+
+  /**
+   * @brief Put the mouse back at the start, after MazeControlAPI::ack_reset()
+   */
+  void restart() noexcept { pose_ = Pose{}; }
+
+  /**
+   * @brief Change the timing used to rank speed-run paths
+   */
+  void set_cost_model(const RunCostModel &model) { runner_ = TimeOptimalPlanner{model}; }
+  [[nodiscard]] const std::vector<Cell> &get_goals() const noexcept { return goals_; }
+  [[nodiscard]] const Map &get_map() const noexcept { return map_; }
+  [[nodiscard]] const Planner &get_planner() const noexcept { return planner_; }
+  [[nodiscard]] const BasicDeadEndPruner<W, H> &get_pruner() const noexcept { return pruner_; }
+  [[nodiscard]] const TimeOptimalPlanner &get_runner() const noexcept { return runner_; }
+  [[nodiscard]] const Pose &get_pose() const noexcept { return pose_; }
+  [[nodiscard]] const Stats &get_stats() const noexcept { return stats_; }
+
+protected:
+  /// Check whether (x, y) is the target goal
+  [[nodiscard]] bool is_target(int x, int y) const noexcept;
+  /// Compute the fields of the other readings the step in flight may get
+  void speculate();
+  /// Mask of the sides of a step's sense field worth reading at @p pose
+  [[nodiscard]] unsigned unknown_sides(const Pose &pose) const noexcept;
+  /// Compute @p planner on @p map towards the goals
+  void plan(Planner &planner, const Map &map);
+  /// Check whether @p field may route through the given side of (x, y)
+  [[nodiscard]] bool on_shortest_path(const Planner &field, int x, int y, Direction side) const noexcept;
+  /// Read the unknown walls on the left, front and right of the mouse into the map
+  void sense();
+  /// Record a wall read at (x, y), for the map and the pruner
+  void observe(int x, int y, Direction direction, bool present);
+  /// Read the walls on the left, front and right of the mouse; false if a known one differs
+  [[nodiscard]] bool confirm();
+  /// Fall back to the walls read in this maze, also on screen
+  void forget();
+  /// Check whether the side of (x, y) leads into a cell the pruner blocked
+  [[nodiscard]] bool leads_to_blocked(int x, int y, Direction side) const noexcept;
+  /// Turn in place until the mouse faces @p direction
+  void face(Direction direction);
+  /// Move @p cells cells along the current heading
+  void advance(int cells = 1);
+  /// Write the distance of every cell in the simulator
+  void draw_distances() const;
+
+  Map map_;
+  // walls read in this maze, or trusted to match it: a subset of map_
+  Map observed_;
+  Planner planner_;
+  BasicDeadEndPruner<W, H> pruner_;
+  // pipelined mode: fields computed in flight, indexed by the mask of the
+  // sides guessed closed, the map of the current guess, and how many fields
+  // the next step may compute
+  static constexpr int kMaxSpeculations = 7;
+  std::array<Planner, kMaxSpeculations + 1> speculative_;
+  Map guess_;
+  int speculation_budget_{0};
+  unsigned speculated_{0}; // bit m set if speculative_[m] holds for command_
+  // exploration in progress
+  StepCommand command_;
+  std::uint64_t max_moves_{0};
+  std::uint64_t moves_made_{0};
+  bool exploring_{false};
+  TimeOptimalPlanner runner_;
+  Pose pose_;
+  std::vector<Cell> goals_;
+  int target_{-1};
+  bool visualize_{false};
+  bool watch_reset_{false};
+  bool pipelined_{false};
+  bool pruning_{false};
+  // planner_ holds a field restored for map_ and goals_, not planned yet
+  bool seeded_{false};
+  Stats stats_;
+}; // class BasicExplorer
+
+/// Explorer for mazes whose dimensions are known at run time
+using Explorer = BasicExplorer<>;
+/// Explorer for 16x16 competition mazes
+using ClassicExplorer = BasicExplorer<kClassicSize, kClassicSize>;
+
+extern template class BasicExplorer<kClassicSize, kClassicSize>;
+extern template class BasicExplorer<kDynamic, kDynamic>;
+
+} // namespace micro_mouse
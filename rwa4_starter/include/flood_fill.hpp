@@ -0,0 +1,478 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "bitboard.hpp"
+#include "maze_map.hpp"
+#include "maze_types.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Constants and options shared by every BasicFloodFillPlanner
+ */
+struct FloodFillBase {
+  /// Distance of cells that cannot reach the goal
+  static constexpr std::uint16_t kUnreachable = 0xFFFF;
+  /// Goals handled by one pass, enough for the four center cells
+  static constexpr int kMaxGoals = 4;
+
+  /**
+   * @brief How walls that have not been observed are treated
+   */
+  enum class WallPolicy {
+    OPTIMISTIC, // unknown walls are open: used to explore
+    KNOWN_ONLY  // unknown walls are closed: paths use verified passages only
+  };
+};
+
+/**
+ * @brief Flood-fill distance planner
+ *
+ * Computes, for every cell, the number of moves to the goal, treating walls
+ * that have not been observed yet as open (or, for speed runs, as closed). On 16x16 maps the breadth-first
+ * wavefront is a Bitboard256 expanded by shift-and-mask against the wall
+ * planes of the MazeMap, so one wavefront step costs a few word operations.
+ * The distances themselves are kept bit-sliced (bit b of every distance in
+ * one bitboard) and only unpacked per cell on request. Other sizes fall back
+ * to a queue-based search.
+ *
+ * Up to kMaxGoals goals can be seeded at once: each goal gets its own
+ * wavefront, all advanced in the same pass, so both the distance to one
+ * particular goal and the distance to the nearest goal are available
+ * afterwards without searching again.
+ *
+ * W and H are the dimensions of the BasicMazeMap it plans on. With 16x16 the
+ * choice of the bitboard wavefront is made at compile time; other fixed
+ * sizes keep their distances in fixed-size arrays; kDynamic decides at run
+ * time.
+ */
+template <int W = kDynamic, int H = kDynamic>
+class BasicFloodFillPlanner : public FloodFillBase {
+public:
+  using Map = BasicMazeMap<W, H>;
+
+  /**
+   * @brief Select the wall policy of the next compute() calls
+   */
+  void set_wall_policy(WallPolicy policy) noexcept { policy_ = policy; }
+
+  /**
+   * @brief Recompute the distance of every cell to a goal cell
+   * @param map Walls known so far
+   * @param goal_x X coordinate of the goal
+   * @param goal_y Y coordinate of the goal
+   */
+  void compute(const Map &map, int goal_x, int goal_y) {
+    const Cell goal{goal_x, goal_y};
+    compute(map, &goal, 1);
+  }
+
+  /**
+   * @brief Recompute the distance of every cell to each of several goals
+   * @param map Walls known so far
+   * @param goals Goal cells, only the first kMaxGoals are used
+   */
+  void compute(const Map &map, const std::vector<Cell> &goals) {
+    compute(map, goals.data(), static_cast<int>(goals.size()));
+  }
+
+  /**
+   * @brief Recompute the distances, leaving some cells out of every path
+   * @param map Walls known so far
+   * @param goals Goal cells, only the first kMaxGoals are used
+   * @param blocked Bit plane of the cells to skip, laid out like the planes
+   * of the map (see BasicDeadEndPruner), or nullptr; blocked cells are
+   * unreachable
+   */
+  void compute(const Map &map, const std::vector<Cell> &goals, const std::uint64_t *blocked) {
+    blocked_ = blocked;
+    compute(map, goals.data(), static_cast<int>(goals.size()));
+    blocked_ = nullptr;
+  }
+
+  /**
+   * @brief Adopt distances computed earlier instead of searching again
+   * @param map Walls the distances were computed on
+   * @param count Number of goals, only the first kMaxGoals are used
+   * @param distances @p count distances per cell, one to each goal, cells
+   * indexed like the MazeMap
+   */
+  void assign(const Map &map, int count, const std::uint16_t *distances);
+
+  [[nodiscard]] int get_goal_count() const noexcept { return goal_count_; }
+
+  /**
+   * @brief Distance from (x, y) to the nearest goal, kUnreachable if none
+   */
+  [[nodiscard]] std::uint16_t get_distance(int x, int y) const noexcept;
+
+  /**
+   * @brief Distance from (x, y) to one goal, kUnreachable if none
+   * @param goal Index of the goal in the list given to compute()
+   */
+  [[nodiscard]] std::uint16_t get_goal_distance(int goal, int x, int y) const noexcept {
+    if (goal < 0 || goal >= goal_count_) {
+      return kUnreachable;
+    }
+    return distance_to(goal, y * width() + x);
+  }
+
+  /**
+   * @brief Index of the goal nearest to (x, y), -1 if none is reachable
+   */
+  [[nodiscard]] int get_nearest_goal(int x, int y) const noexcept;
+
+  /**
+   * @brief Distance of every cell to the nearest goal, indexed like the MazeMap
+   */
+  [[nodiscard]] const std::vector<std::uint16_t> &get_distances() const;
+
+  /**
+   * @brief Best direction to leave a cell
+   *
+   * Picks the open neighbour with the smallest distance, preferring to keep
+   * the current heading on ties so the mouse turns as little as possible.
+   * @param map Walls known so far, the ones used by the last compute()
+   * @param pose Cell and heading of the mouse
+   * @param direction Receives the direction to take
+   * @param goal Goal to head for, or -1 for the nearest one
+   * @return false if no open neighbour is closer to the goal
+   */
+  bool next_direction(const Map &map, const Pose &pose, Direction &direction, int goal = -1) const noexcept;
+
+private:
+  // 16x16 distances need at most 8 bits; one more keeps the format general
+  static constexpr int kSlices = 9;
+  // the bitboard wavefront always serves fixed 16x16 maps, never other fixed
+  // sizes, and dynamic maps when they happen to be 16x16
+  static constexpr bool kAlwaysSliced = W == 16 && H == 16;
+  static constexpr bool kMaybeSliced = kAlwaysSliced || W == kDynamic;
+
+  [[nodiscard]] bool sliced() const noexcept {
+    if constexpr (kAlwaysSliced) {
+      return true;
+    } else if constexpr (kMaybeSliced) {
+      return sliced_;
+    } else {
+      return false;
+    }
+  }
+  [[nodiscard]] int width() const noexcept {
+    if constexpr (Map::kFixed) {
+      return W;
+    } else {
+      return width_;
+    }
+  }
+  [[nodiscard]] int height() const noexcept {
+    if constexpr (Map::kFixed) {
+      return H;
+    } else {
+      return height_;
+    }
+  }
+
+  void compute(const Map &map, const Cell *goals, int count);
+  template <int Goals>
+  void compute_bitboard(const Map &map, const Bitboard256 (&seeds)[kMaxGoals]);
+  void compute_queue(const Map &map, const Cell *goals);
+  [[nodiscard]] std::uint16_t sliced_distance(int goal, int cell) const noexcept;
+  [[nodiscard]] std::uint16_t distance_to(int goal, int cell) const noexcept {
+    if (sliced()) {
+      return sliced_distance(goal, cell);
+    }
+    return goal_distances_[static_cast<std::size_t>(cell)][static_cast<std::size_t>(goal)];
+  }
+  // Load a 16x16 map plane into a bitboard
+  [[nodiscard]] static Bitboard256 load(const Map &map, typename Map::Plane plane) noexcept {
+    const std::uint64_t *words = map.get_plane(plane);
+    return {{words[0], words[1], words[2], words[3]}};
+  }
+
+  int width_{0};
+  int height_{0};
+  int goal_count_{0};
+  WallPolicy policy_{WallPolicy::OPTIMISTIC};
+  // cells skipped by the compute() in progress, or nullptr
+  const std::uint64_t *blocked_{nullptr};
+  bool sliced_{false};
+  Bitboard256 reached_[kMaxGoals];
+  Bitboard256 slices_[kMaxGoals][kSlices];
+  // queue search: the distance of each cell to every goal; left empty when
+  // the bitboards always serve
+  CellArray<std::array<std::uint16_t, kMaxGoals>, kAlwaysSliced ? kDynamic : W, kAlwaysSliced ? kDynamic : H>
+      goal_distances_{};
+  std::vector<int> queue_;
+  // nearest goal distances, unpacked on demand
+  mutable std::vector<std::uint16_t> distances_;
+  mutable bool unpacked_{false};
+}; // class BasicFloodFillPlanner
+
+/// Planner for maps whose dimensions are known at run time
+using FloodFillPlanner = BasicFloodFillPlanner<>;
+/// Planner for 16x16 competition maps
+using ClassicFloodFillPlanner = BasicFloodFillPlanner<kClassicSize, kClassicSize>;
+
+template <int W, int H>
+void BasicFloodFillPlanner<W, H>::compute(const Map &map, const Cell *goals, int count) {
+  width_ = map.get_width();
+  height_ = map.get_height();
+  goal_count_ = std::min(count, kMaxGoals);
+  unpacked_ = false;
+  if constexpr (kMaybeSliced) {
+    sliced_ = width_ == 16 && height_ == 16;
+    if (sliced()) {
+      Bitboard256 seeds[kMaxGoals];
+      for (int g = 0; g < goal_count_; ++g) {
+        const auto &goal = goals[g];
+        if (map.contains(goal.x, goal.y)) {
+          seeds[g].set(map.index(goal.x, goal.y));
+        }
+      }
+      switch (goal_count_) {
+      case 1: compute_bitboard<1>(map, seeds); break;
+      case 2: compute_bitboard<2>(map, seeds); break;
+      case 3: compute_bitboard<3>(map, seeds); break;
+      case 4: compute_bitboard<4>(map, seeds); break;
+      default: break;
+      }
+      return;
+    }
+  }
+  compute_queue(map, goals);
+}
+
+template <int W, int H>
+void BasicFloodFillPlanner<W, H>::assign(const Map &map, int count, const std::uint16_t *distances) {
+  width_ = map.get_width();
+  height_ = map.get_height();
+  goal_count_ = std::min(count, kMaxGoals);
+  unpacked_ = false;
+  const int cells = map.get_cell_count();
+  auto distance = [&](int cell, int goal) { return distances[static_cast<std::size_t>(cell * count + goal)]; };
+  if constexpr (kMaybeSliced) {
+    sliced_ = width_ == 16 && height_ == 16;
+    if (sliced()) {
+      // the Gray-coded slices compute_bitboard() leaves for these distances
+      for (int g = 0; g < goal_count_; ++g) {
+        reached_[g] = Bitboard256{};
+        std::fill(std::begin(slices_[g]), std::end(slices_[g]), Bitboard256{});
+        for (int cell = 0; cell < cells; ++cell) {
+          const unsigned d = distance(cell, g);
+          if (d == kUnreachable) {
+            continue;
+          }
+          reached_[g].set(cell);
+          const unsigned gray = d ^ (d >> 1);
+          for (int b = 0; b < kSlices; ++b) {
+            if ((gray >> b) & 1U) {
+              slices_[g][b].set(cell);
+            }
+          }
+        }
+      }
+      return;
+    }
+  }
+  std::array<std::uint16_t, kMaxGoals> unreached{};
+  unreached.fill(kUnreachable);
+  fill_cells(goal_distances_, static_cast<std::size_t>(cells), unreached);
+  for (int cell = 0; cell < cells; ++cell) {
+    for (int g = 0; g < goal_count_; ++g) {
+      goal_distances_[static_cast<std::size_t>(cell)][static_cast<std::size_t>(g)] = distance(cell, g);
+    }
+  }
+}
+
+template <int W, int H>
+template <int Goals>
+void BasicFloodFillPlanner<W, H>::compute_bitboard(const Map &map, const Bitboard256 (&seeds)[kMaxGoals]) {
+  // unknown walls count as open unless the policy says otherwise; the
+  // boundary bits are always known and present, so shifted cells never wrap
+  // to the next row or leave the maze
+  Bitboard256 open_east = ~load(map, Map::Plane::EAST_PRESENT);
+  Bitboard256 open_north = ~load(map, Map::Plane::NORTH_PRESENT);
+  if (policy_ == WallPolicy::KNOWN_ONLY) {
+    open_east = open_east & load(map, Map::Plane::EAST_KNOWN);
+    open_north = open_north & load(map, Map::Plane::NORTH_KNOWN);
+  }
+  // cell i is open to the west when cell i - 1 is open to the east
+  const Bitboard256 open_west = open_east.shifted_up(1);
+  const Bitboard256 open_south = open_north.shifted_up(16);
+
+  // Distances are stored as Gray codes, bit-sliced: consecutive distances
+  // differ in a single bit, so each wavefront step updates one slice. When
+  // bit b switches on at distance d, every cell not reached yet tentatively
+  // gets it; when it switches off, the cells still unreached lose it again.
+  // All the goals advance in lockstep, one wavefront each; the goal count
+  // is a template parameter so that the lane loops unroll.
+  Bitboard256 slices[Goals][kSlices];
+  Bitboard256 visited[Goals];
+  Bitboard256 frontier[Goals];
+  // blocked cells start out visited, so that no wavefront enters them
+  Bitboard256 blocked;
+  if (blocked_ != nullptr) {
+    blocked = {{blocked_[0], blocked_[1], blocked_[2], blocked_[3]}};
+  }
+  for (int g = 0; g < Goals; ++g) {
+    visited[g] = seeds[g] | blocked;
+    frontier[g] = seeds[g];
+  }
+  bool active = true;
+  for (unsigned distance = 1; active; ++distance) {
+    const int b = __builtin_ctz(distance);
+    const std::uint64_t on = std::uint64_t{0} - (((distance ^ (distance >> 1)) >> b) & 1U);
+    active = false;
+    for (int g = 0; g < Goals; ++g) {
+      const Bitboard256 &f = frontier[g];
+      const Bitboard256 next = (f & open_east).shifted_up(1) | (f & open_west).shifted_down(1) |
+                               (f & open_north).shifted_up(16) | (f & open_south).shifted_down(16);
+      frontier[g] = next & ~visited[g];
+      if (!frontier[g].any()) {
+        continue;
+      }
+      active = true;
+      for (int w = 0; w < 4; ++w) {
+        slices[g][b].words[w] = (slices[g][b].words[w] & visited[g].words[w]) | (~visited[g].words[w] & on);
+      }
+      visited[g] = visited[g] | frontier[g];
+    }
+  }
+  for (int g = 0; g < Goals; ++g) {
+    reached_[g] = visited[g] & ~blocked;
+    std::copy(std::begin(slices[g]), std::end(slices[g]), std::begin(slices_[g]));
+  }
+}
+
+template <int W, int H>
+void BasicFloodFillPlanner<W, H>::compute_queue(const Map &map, const Cell *goals) {
+  // one FIFO for all the goals: entries come out in increasing distance
+  // whatever their goal, so every field is a correct breadth-first search.
+  // An entry is kMaxGoals * cell + goal.
+  const int cells = map.get_cell_count();
+  std::array<std::uint16_t, kMaxGoals> unreached{};
+  unreached.fill(kUnreachable);
+  fill_cells(goal_distances_, static_cast<std::size_t>(cells), unreached);
+  queue_.clear();
+  for (int g = 0; g < goal_count_; ++g) {
+    const auto &goal = goals[g];
+    if (map.contains(goal.x, goal.y)) {
+      const int cell = map.index(goal.x, goal.y);
+      goal_distances_[static_cast<std::size_t>(cell)][static_cast<std::size_t>(g)] = 0;
+      queue_.push_back(kMaxGoals * cell + g);
+    }
+  }
+  for (std::size_t head = 0; head < queue_.size(); ++head) {
+    const int entry = queue_[head];
+    const int cell = entry / kMaxGoals;
+    const auto goal = static_cast<std::size_t>(entry % kMaxGoals);
+    const int x = cell % width();
+    const int y = cell / width();
+    const auto next_distance =
+        static_cast<std::uint16_t>(goal_distances_[static_cast<std::size_t>(cell)][goal] + 1);
+    for (int d = 0; d < 4; ++d) {
+      const auto direction = static_cast<Direction>(d);
+      if (map.has_wall(x, y, direction) ||
+          (policy_ == WallPolicy::KNOWN_ONLY && !map.is_known(x, y, direction))) {
+        continue;
+      }
+      const int neighbour = map.index(x + dx(direction), y + dy(direction));
+      if (blocked_ != nullptr && ((blocked_[neighbour >> 6] >> (neighbour & 63)) & 1U)) {
+        continue;
+      }
+      std::uint16_t &distance = goal_distances_[static_cast<std::size_t>(neighbour)][goal];
+      if (distance == kUnreachable) {
+        distance = next_distance;
+        queue_.push_back(kMaxGoals * neighbour + static_cast<int>(goal));
+      }
+    }
+  }
+}
+
+template <int W, int H>
+std::uint16_t BasicFloodFillPlanner<W, H>::sliced_distance(int goal, int cell) const noexcept {
+  if (!reached_[goal].test(cell)) {
+    return kUnreachable;
+  }
+  unsigned gray = 0;
+  for (int b = 0; b < kSlices; ++b) {
+    gray |= static_cast<unsigned>(slices_[goal][b].test(cell)) << b;
+  }
+  unsigned distance = gray;
+  for (unsigned shift = gray >> 1; shift != 0; shift >>= 1) {
+    distance ^= shift;
+  }
+  return static_cast<std::uint16_t>(distance);
+}
+
+template <int W, int H>
+std::uint16_t BasicFloodFillPlanner<W, H>::get_distance(int x, int y) const noexcept {
+  std::uint16_t best = kUnreachable;
+  for (int g = 0; g < goal_count_; ++g) {
+    best = std::min(best, distance_to(g, y * width() + x));
+  }
+  return best;
+}
+
+template <int W, int H>
+int BasicFloodFillPlanner<W, H>::get_nearest_goal(int x, int y) const noexcept {
+  int nearest = -1;
+  std::uint16_t best = kUnreachable;
+  for (int g = 0; g < goal_count_; ++g) {
+    const std::uint16_t distance = distance_to(g, y * width() + x);
+    if (distance < best) {
+      best = distance;
+      nearest = g;
+    }
+  }
+  return nearest;
+}
+
+template <int W, int H>
+const std::vector<std::uint16_t> &BasicFloodFillPlanner<W, H>::get_distances() const {
+  if (!unpacked_) {
+    distances_.resize(static_cast<std::size_t>(width() * height()));
+    for (int y = 0; y < height(); ++y) {
+      for (int x = 0; x < width(); ++x) {
+        distances_[static_cast<std::size_t>(y * width() + x)] = get_distance(x, y);
+      }
+    }
+    unpacked_ = true;
+  }
+  return distances_;
+}
+
+template <int W, int H>
+bool BasicFloodFillPlanner<W, H>::next_direction(const Map &map, const Pose &pose, Direction &direction,
+                                                 int goal) const noexcept {
+  auto distance_from = [this, goal](int x, int y) {
+    return goal < 0 ? get_distance(x, y) : get_goal_distance(goal, x, y);
+  };
+  std::uint16_t best = distance_from(pose.x, pose.y);
+  bool found = false;
+  // current heading first, so that it wins ties
+  const Direction candidates[] = {pose.heading, turn_left(pose.heading), turn_right(pose.heading), opposite(pose.heading)};
+  for (const auto candidate : candidates) {
+    if (map.has_wall(pose.x, pose.y, candidate) ||
+        (policy_ == WallPolicy::KNOWN_ONLY && !map.is_known(pose.x, pose.y, candidate))) {
+      continue;
+    }
+    const std::uint16_t distance = distance_from(pose.x + dx(candidate), pose.y + dy(candidate));
+    if (distance < best) {
+      best = distance;
+      direction = candidate;
+      found = true;
+    }
+  }
+  return found;
+}
+
+// compiled once in flood_fill.cpp
+extern template class BasicFloodFillPlanner<kClassicSize, kClassicSize>;
+extern template class BasicFloodFillPlanner<kDynamic, kDynamic>;
+
+} // namespace micro_mouse
@@ -0,0 +1,290 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "maze_map.hpp"
+#include "maze_types.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Distance planner repaired incrementally as walls are discovered
+ *
+ * Like FloodFillPlanner, it keeps the distance of every cell to the goal
+ * with unobserved walls treated as open, and searches backwards from the
+ * goal, so moving the mouse never invalidates anything (the D* Lite idea).
+ * Discovering a wall can only lengthen paths: instead of a full recompute,
+ * the cells whose shortest path ran through the new wall are found by
+ * following the search tree from the wall, and only they are re-settled.
+ *
+ * W and H are the dimensions of the BasicMazeMap it plans on; fixed sizes
+ * keep the per-cell state in fixed-size arrays.
+ */
+template <int W = kDynamic, int H = kDynamic>
+class BasicIncrementalPlanner {
+public:
+  using Map = BasicMazeMap<W, H>;
+
+  /// Distance of cells that cannot reach the goal
+  static constexpr int kUnreachable = 1 << 30;
+
+  /**
+   * @brief Compute all distances from scratch
+   * @param map Walls known so far
+   * @param goals Indices (MazeMap::index) of the goal cells
+   */
+  void reset(const Map &map, const std::vector<int> &goals);
+
+  /**
+   * @brief Repair the distances after a wall was added to the map
+   *
+   * Call once per wall, after MazeMap::set_wall() reported a new present
+   * wall. Walls found to be absent never change the distances.
+   */
+  void wall_added(const Map &map, int x, int y, Direction direction);
+
+  [[nodiscard]] int get_distance(int x, int y) const noexcept {
+    return distances_[static_cast<std::size_t>(y * width() + x)];
+  }
+  [[nodiscard]] const CellArray<int, W, H> &get_distances() const noexcept { return distances_; }
+
+  /**
+   * @brief Best direction to leave a cell, see FloodFillPlanner::next_direction
+   */
+  bool next_direction(const Map &map, const Pose &pose, Direction &direction) const noexcept;
+
+  /// Cells examined by the last reset() or wall_added()
+  [[nodiscard]] std::uint64_t get_last_touched() const noexcept { return last_touched_; }
+  /// Cells examined since the last reset(), including it
+  [[nodiscard]] std::uint64_t get_total_touched() const noexcept { return total_touched_; }
+
+private:
+  static constexpr std::uint8_t kExamined = 1;
+  static constexpr std::uint8_t kOrphan = 2;
+
+  [[nodiscard]] int width() const noexcept {
+    if constexpr (Map::kFixed) {
+      return W;
+    } else {
+      return width_;
+    }
+  }
+  // Open neighbours of a cell, as cell indices; returns how many
+  int neighbours(int cell, int (&out)[4]) const noexcept;
+  void touch(int cell);
+
+  int width_{0};
+  CellArray<int, W, H> distances_{};
+  CellArray<std::uint8_t, W, H> is_goal_{};
+  // bit d set when the cell is open towards Direction(d), mirrors the map
+  CellArray<std::uint8_t, W, H> open_{};
+  // per update scratch: 1 = examined, 2 = orphaned (lost its shortest path)
+  CellArray<std::uint8_t, W, H> state_{};
+  std::vector<int> touched_;
+  std::vector<int> candidates_;
+  std::vector<int> orphans_;
+  std::vector<std::pair<int, int>> heap_;
+  std::uint64_t last_touched_{0};
+  std::uint64_t total_touched_{0};
+}; // class BasicIncrementalPlanner
+
+/// Planner for maps whose dimensions are known at run time
+using IncrementalPlanner = BasicIncrementalPlanner<>;
+/// Planner for 16x16 competition maps
+using ClassicIncrementalPlanner = BasicIncrementalPlanner<kClassicSize, kClassicSize>;
+
+template <int W, int H>
+int BasicIncrementalPlanner<W, H>::neighbours(int cell, int (&out)[4]) const noexcept {
+  // cell offsets of one step north, east, south and west
+  const int offsets[] = {width(), 1, -width(), -1};
+  const std::uint8_t open = open_[static_cast<std::size_t>(cell)];
+  int count = 0;
+  for (int d = 0; d < 4; ++d) {
+    if ((open >> d) & 1U) {
+      out[count++] = cell + offsets[d];
+    }
+  }
+  return count;
+}
+
+template <int W, int H>
+void BasicIncrementalPlanner<W, H>::touch(int cell) {
+  if (state_[static_cast<std::size_t>(cell)] == 0) {
+    state_[static_cast<std::size_t>(cell)] = kExamined;
+    touched_.push_back(cell);
+  }
+}
+
+template <int W, int H>
+void BasicIncrementalPlanner<W, H>::reset(const Map &map, const std::vector<int> &goals) {
+  width_ = map.get_width();
+  const auto cells = static_cast<std::size_t>(map.get_cell_count());
+  fill_cells(distances_, cells, kUnreachable);
+  fill_cells(is_goal_, cells, 0);
+  fill_cells(state_, cells, 0);
+  fill_cells(open_, cells, 0);
+  for (int y = 0; y < map.get_height(); ++y) {
+    for (int x = 0; x < width(); ++x) {
+      for (int d = 0; d < 4; ++d) {
+        if (!map.has_wall(x, y, static_cast<Direction>(d))) {
+          open_[static_cast<std::size_t>(map.index(x, y))] |= static_cast<std::uint8_t>(1U << d);
+        }
+      }
+    }
+  }
+
+  // plain breadth-first search from all the goals
+  std::vector<int> &queue = candidates_;
+  queue.clear();
+  for (const int goal : goals) {
+    if (goal >= 0 && static_cast<std::size_t>(goal) < cells && !is_goal_[static_cast<std::size_t>(goal)]) {
+      is_goal_[static_cast<std::size_t>(goal)] = 1;
+      distances_[static_cast<std::size_t>(goal)] = 0;
+      queue.push_back(goal);
+    }
+  }
+  int adjacent[4];
+  for (std::size_t head = 0; head < queue.size(); ++head) {
+    const int cell = queue[head];
+    const int count = neighbours(cell, adjacent);
+    for (int i = 0; i < count; ++i) {
+      int &distance = distances_[static_cast<std::size_t>(adjacent[i])];
+      if (distance == kUnreachable) {
+        distance = distances_[static_cast<std::size_t>(cell)] + 1;
+        queue.push_back(adjacent[i]);
+      }
+    }
+  }
+  last_touched_ = cells;
+  total_touched_ = cells;
+}
+
+template <int W, int H>
+void BasicIncrementalPlanner<W, H>::wall_added(const Map &map, int x, int y, Direction direction) {
+  last_touched_ = 0;
+  if (!map.contains(x, y) || !map.contains(x + dx(direction), y + dy(direction))) {
+    return;
+  }
+  const int a = map.index(x, y);
+  const int b = map.index(x + dx(direction), y + dy(direction));
+  open_[static_cast<std::size_t>(a)] &= static_cast<std::uint8_t>(~(1U << static_cast<int>(direction)));
+  open_[static_cast<std::size_t>(b)] &= static_cast<std::uint8_t>(~(1U << static_cast<int>(opposite(direction))));
+  const int da = distances_[static_cast<std::size_t>(a)];
+  const int db = distances_[static_cast<std::size_t>(b)];
+  // only the endpoint that was one step further can have used the wall
+  int start = -1;
+  if (da != kUnreachable && da == db + 1) {
+    start = a;
+  } else if (db != kUnreachable && db == da + 1) {
+    start = b;
+  }
+  if (start < 0) {
+    return;
+  }
+
+  // 1. Find the orphans: cells left without a neighbour one step closer to
+  // the goal. Candidates come out of the FIFO in increasing distance, so
+  // every possible parent of a cell is settled before the cell is checked.
+  int adjacent[4];
+  candidates_.clear();
+  candidates_.push_back(start);
+  touch(start);
+  orphans_.clear();
+  for (std::size_t head = 0; head < candidates_.size(); ++head) {
+    const int cell = candidates_[head];
+    const int distance = distances_[static_cast<std::size_t>(cell)];
+    if (is_goal_[static_cast<std::size_t>(cell)]) {
+      continue;
+    }
+    const int count = neighbours(cell, adjacent);
+    bool supported = false;
+    for (int i = 0; i < count && !supported; ++i) {
+      supported = state_[static_cast<std::size_t>(adjacent[i])] != kOrphan &&
+            distances_[static_cast<std::size_t>(adjacent[i])] == distance - 1;
+    }
+    if (supported) {
+      continue;
+    }
+    state_[static_cast<std::size_t>(cell)] = kOrphan;
+    orphans_.push_back(cell);
+    for (int i = 0; i < count; ++i) {
+      const int child = adjacent[i];
+      if (state_[static_cast<std::size_t>(child)] == 0 && distances_[static_cast<std::size_t>(child)] == distance + 1) {
+        touch(child);
+        candidates_.push_back(child);
+      }
+    }
+  }
+
+  // 2. Re-settle the orphans: seed each one from its settled neighbours,
+  // then run Dijkstra restricted to the orphans
+  heap_.clear();
+  for (const int orphan : orphans_) {
+    int best = kUnreachable;
+    const int count = neighbours(orphan, adjacent);
+    for (int i = 0; i < count; ++i) {
+      const int neighbour = adjacent[i];
+      if (state_[static_cast<std::size_t>(neighbour)] != kOrphan) {
+        best = std::min(best, distances_[static_cast<std::size_t>(neighbour)] + 1);
+      }
+    }
+    distances_[static_cast<std::size_t>(orphan)] = best;
+    if (best != kUnreachable) {
+      heap_.emplace_back(best, orphan);
+    }
+  }
+  std::make_heap(heap_.begin(), heap_.end(), std::greater<>());
+  while (!heap_.empty()) {
+    std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+    const auto [distance, cell] = heap_.back();
+    heap_.pop_back();
+    if (distance != distances_[static_cast<std::size_t>(cell)]) {
+      continue; // stale entry
+    }
+    const int count = neighbours(cell, adjacent);
+    for (int i = 0; i < count; ++i) {
+      const int neighbour = adjacent[i];
+      int &other = distances_[static_cast<std::size_t>(neighbour)];
+      if (state_[static_cast<std::size_t>(neighbour)] == kOrphan && distance + 1 < other) {
+        other = distance + 1;
+        heap_.emplace_back(other, neighbour);
+        std::push_heap(heap_.begin(), heap_.end(), std::greater<>());
+      }
+    }
+  }
+
+  last_touched_ = touched_.size();
+  total_touched_ += last_touched_;
+  for (const int cell : touched_) {
+    state_[static_cast<std::size_t>(cell)] = 0;
+  }
+  touched_.clear();
+}
+
+template <int W, int H>
+bool BasicIncrementalPlanner<W, H>::next_direction(const Map &map, const Pose &pose, Direction &direction) const noexcept {
+  int best = get_distance(pose.x, pose.y);
+  bool found = false;
+  const Direction candidates[] = {pose.heading, turn_left(pose.heading), turn_right(pose.heading), opposite(pose.heading)};
+  for (const auto candidate : candidates) {
+    if (map.has_wall(pose.x, pose.y, candidate)) {
+      continue;
+    }
+    const int distance = get_distance(pose.x + dx(candidate), pose.y + dy(candidate));
+    if (distance < best) {
+      best = distance;
+      direction = candidate;
+      found = true;
+    }
+  }
+  return found;
+}
+
+// compiled once in incremental_planner.cpp
+extern template class BasicIncrementalPlanner<kClassicSize, kClassicSize>;
+extern template class BasicIncrementalPlanner<kDynamic, kDynamic>;
+
+} // namespace micro_mouse
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace micro_mouse {
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ *
+ * The content is paged in by the kernel on access; nothing is copied into
+ * the process. The mapping is released when the object is destroyed.
+ */
+class MappedFile {
+public:
+  MappedFile() noexcept = default;
+
+  /**
+   * @brief Map a file
+   * @param path Path to the file
+   * @throw std::runtime_error if the file cannot be opened or mapped
+   */
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  [[nodiscard]] const char *data() const noexcept { return data_; }
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] std::string_view view() const noexcept { return {data_, size_}; }
+
+private:
+  void release() noexcept;
+
+  const char *data_{nullptr};
+  std::size_t size_{0};
+}; // class MappedFile
+
+} // namespace micro_mouse
@@ -1,16 +1,54 @@
 #pragma once
 #include <string>
+#include <string_view>
 
 namespace micro_mouse {
 
+class MazeBackend;
+class VisualizationShadow;
+
+/**
+ * @brief Commands of one step, sent together by MazeControlAPI::post_step()
+ */
+struct StepCommand {
+  int turns{0};            // quarter turns before the move: 1 right, 2 around, 3 left
+  int distance{1};         // cells to move forward, 0 to stay and only turn and read
+  bool check_reset{false}; // query was_reset() after the move
+  unsigned sense{7};       // walls queried after the move: 1 left, 2 front, 4 right
+};
+
+/**
+ * @brief Replies to a StepCommand, false where the query was not sent
+ */
+struct StepReply {
+  bool reset{false};
+  bool wall_left{false};
+  bool wall_front{false};
+  bool wall_right{false};
+};
+
 /**
  * @brief API for controlling and interacting with a maze environment
  *
  * This class provides methods to navigate through a maze, query maze
  * properties, manipulate walls, set colors and text, and handle reset events.
+ * Calls are forwarded to the active MazeBackend, which by default speaks the
+ * mms text protocol over stdin/stdout.
  */
 class MazeControlAPI {
 public:
+  /**
+   * @brief Select the backend receiving all subsequent calls of this thread
+   * @param backend Backend to use, or nullptr for the mms text protocol. The
+   * backend is not owned and must stay alive while it is selected.
+   */
+  static void set_backend(MazeBackend *backend);
+
+  /**
+   * @brief Get the backend currently receiving the calls
+   */
+  static MazeBackend &get_backend();
+
   /**
    * @brief Get the width of the maze
    * @return The width of the maze in cells
@@ -126,6 +164,59 @@ public:
    */
   static void ack_reset();
 
+  /**
+   * @brief Send the commands of one step without waiting for their replies
+   *
+   * Turns, moves and queries exactly as the separate calls would, in the
+   * order of the StepCommand fields, but the caller can work while the
+   * simulator answers and collect the replies with wait_step(). Until then,
+   * only visualization commands may be sent. Backends answering in-process
+   * run the whole step in wait_step().
+   * @param step Commands to send
+   * @throw std::runtime_error if a step is already in flight
+   */
+  static void post_step(const StepCommand &step);
+
+  /**
+   * @brief Wait for the replies of the step sent by post_step()
+   * @return The readings taken after the move
+   * @throw std::runtime_error if no step is in flight or the move failed
+   */
+  static StepReply wait_step();
+
+  /**
+   * @brief Queue visualization commands instead of sending them one by one
+   *
+   * When enabled, set_wall, clear_wall, set_color, clear_color, set_text,
+   * clear_text and the clear_all variants are held back and sent in one
+   * write right before the next command that needs a reply, or on flush().
+   * @param buffered true to enable buffering (disabled by default)
+   */
+  static void set_buffered_visualization(bool buffered);
+
+  /**
+   * @brief Send the visualization commands queued so far
+   */
+  static void flush();
+
+  /**
+   * @brief Drop visualization calls that would not change the display
+   *
+   * A shadow copy of the colors, texts and wall markers already sent is kept
+   * on the client side; calls repeating the current state are not sent.
+   * Enabling the shadow starts from an empty display, so enable it before
+   * drawing anything. Like the backend, the shadow belongs to the calling
+   * thread.
+   * @param enabled true to enable the shadow (disabled by default)
+   */
+  static void set_shadow_enabled(bool enabled);
+
+  /**
+   * @brief Get the shadow copy, for its forwarded/suppressed counters
+   * @return The shadow, or nullptr when disabled
+   */
+  static const VisualizationShadow *get_shadow();
+
   /**
    * @brief Print a message in the simulator
    * To print anything in the simulator, use std::cerr
@@ -0,0 +1,128 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+#include "maze_api.hpp"
+#include "reply_reader.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Transport used by MazeControlAPI to reach a maze
+ *
+ * Each MazeControlAPI call is forwarded to the active backend. The default
+ * backend speaks the mms text protocol over stdin/stdout; other backends can
+ * answer the same calls in-process.
+ */
+class MazeBackend {
+public:
+  virtual ~MazeBackend() = default;
+
+  virtual int get_maze_width() = 0;
+  virtual int get_maze_height() = 0;
+  virtual bool has_wall_front() = 0;
+  virtual bool has_wall_right() = 0;
+  virtual bool has_wall_left() = 0;
+  virtual void move_forward(int distance) = 0;
+  virtual void turn_right() = 0;
+  virtual void turn_left() = 0;
+  virtual void set_wall(int x, int y, char direction) = 0;
+  virtual void clear_wall(int x, int y, char direction) = 0;
+  virtual void set_color(int x, int y, char color) = 0;
+  virtual void clear_color(int x, int y) = 0;
+  virtual void clear_all_color() = 0;
+  virtual void set_text(int x, int y, const std::string &text) = 0;
+  virtual void clear_text(int x, int y) = 0;
+  virtual void clear_all_text() = 0;
+  virtual bool was_reset() = 0;
+  virtual void ack_reset() = 0;
+
+  /**
+   * @brief Choose whether visualization commands may be held back
+   * @param buffered true to queue commands that have no reply until the next
+   * command that needs one
+   */
+  virtual void set_buffered_visualization(bool buffered) { (void)buffered; }
+
+  /**
+   * @brief Send any queued visualization commands now
+   */
+  virtual void flush() {}
+
+  /**
+   * @brief Send a step without waiting, see MazeControlAPI::post_step()
+   *
+   * The default only records the step, and wait_step() runs it with the
+   * calls above; backends with a round trip override both to overlap it.
+   */
+  virtual void post_step(const StepCommand &step);
+
+  /**
+   * @brief Collect the replies of the posted step
+   */
+  virtual StepReply wait_step();
+
+protected:
+  /// Hand over the posted step and clear it
+  StepCommand take_step();
+
+private:
+  StepCommand step_;
+  bool step_posted_{false};
+}; // class MazeBackend
+
+/**
+ * @brief Backend talking to the mms simulator through stdin/stdout
+ *
+ * Every command is written as one text line and, when the command has a
+ * reply, the reply is read back from stdin with a ReplyReader, which parses
+ * it in place without allocating. In buffered mode, visualization
+ * commands are queued and written together, in a single flush, with the next
+ * command that waits for a reply. A posted step is written in one flush as
+ * well, and its replies are read only by wait_step().
+ */
+class TextPipeBackend : public MazeBackend {
+public:
+  ~TextPipeBackend() override;
+
+  int get_maze_width() override;
+  int get_maze_height() override;
+  bool has_wall_front() override;
+  bool has_wall_right() override;
+  bool has_wall_left() override;
+  void move_forward(int distance) override;
+  void turn_right() override;
+  void turn_left() override;
+  void set_wall(int x, int y, char direction) override;
+  void clear_wall(int x, int y, char direction) override;
+  void set_color(int x, int y, char color) override;
+  void clear_color(int x, int y) override;
+  void clear_all_color() override;
+  void set_text(int x, int y, const std::string &text) override;
+  void clear_text(int x, int y) override;
+  void clear_all_text() override;
+  bool was_reset() override;
+  void ack_reset() override;
+  void set_buffered_visualization(bool buffered) override { buffered_ = buffered; }
+  void flush() override;
+  void post_step(const StepCommand &step) override;
+  StepReply wait_step() override;
+
+private:
+  // Append one command line to the pending output
+  template <typename... Args>
+  void write_command(std::string_view command, const Args &...args);
+  void write_move(int distance);
+  // Queue a fire-and-forget command, written at once unless buffered
+  template <typename... Args>
+  void queue(std::string_view command, const Args &...args);
+  // Write the queued commands followed by a command expecting a reply
+  template <typename... Args>
+  void send_request(std::string_view command, const Args &...args);
+
+  bool buffered_{false};
+  std::string pending_;
+  ReplyReader reader_;
+}; // class TextPipeBackend
+
+} // namespace micro_mouse
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "maze_simulator.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Binary maze corpus, mapped in one call and read in place
+ *
+ * The file holds a header, a fixed-size index entry per maze, the walls of
+ * each maze packed 4 bits per cell (MazeSimulator::pack()) and the maze
+ * names. Opening a corpus maps the file and checks the index; no maze is
+ * parsed, load() only unpacks the walls of the requested one. Integers are
+ * stored in host byte order, which the header records.
+ */
+class MazeCorpus {
+public:
+  /**
+   * @brief Map a corpus file
+   * @param path File written by write()
+   * @throw std::runtime_error if the file cannot be mapped or is not a
+   * valid corpus
+   */
+  explicit MazeCorpus(const std::string &path);
+
+  /**
+   * @brief Write a corpus file
+   * @param path Output file
+   * @param names Name of each maze, usually the file name it came from
+   * @param mazes Mazes, in the same order as @p names
+   * @throw std::runtime_error if the file cannot be written
+   */
+  static void write(const std::string &path, const std::vector<std::string> &names,
+                    const std::vector<MazeSimulator> &mazes);
+
+  [[nodiscard]] std::size_t size() const noexcept { return count_; }
+  [[nodiscard]] std::string_view get_name(std::size_t maze) const noexcept;
+  [[nodiscard]] int get_width(std::size_t maze) const noexcept;
+  [[nodiscard]] int get_height(std::size_t maze) const noexcept;
+
+  /**
+   * @brief Build the simulator of one maze, mouse at the start
+   */
+  [[nodiscard]] MazeSimulator load(std::size_t maze) const;
+
+private:
+  struct Entry;
+  [[nodiscard]] const Entry &entry(std::size_t maze) const noexcept;
+
+  MappedFile file_;
+  std::size_t count_{0};
+}; // class MazeCorpus
+
+} // namespace micro_mouse
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "maze_simulator.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @struct RuleCheck
+ * @brief Which of the competition maze rules a maze satisfies
+ */
+struct RuleCheck {
+  bool enclosed{false};          // the outer boundary is closed
+  bool start_walls{false};       // the start cell is only open to the north
+  bool hollow_center{false};     // no wall inside the center block
+  bool single_entrance{false};   // one opening into the center block
+  bool not_wall_followable{false}; // neither hand rule reaches the center
+
+  [[nodiscard]] bool all() const noexcept {
+    return enclosed && start_walls && hollow_center && single_entrance && not_wall_followable;
+  }
+};
+
+/**
+ * @brief Check a maze against the competition rules
+ *
+ * The center block is made of the goal cells of MazeSimulator::is_goal(). The
+ * wall followers start at (0, 0) facing north and keep a hand on the left,
+ * respectively right, wall.
+ */
+RuleCheck check_rules(const MazeSimulator &maze);
+
+/**
+ * @brief Fast random maze generator
+ *
+ * A depth-first carve from the start cell gives a perfect maze, with the
+ * center block carved as a single room entered once. For multi-path mazes
+ * the walls around the center are then cut off from the outer wall, which
+ * is what defeats wall followers, and a fraction of the remaining inner
+ * walls is removed. The rules hold by construction; check_rules() verifies
+ * them independently. The buffers are reused, so a generator produces mazes
+ * without allocating beyond the returned simulator; use one generator per
+ * thread.
+ */
+class MazeGenerator {
+public:
+  /**
+   * @struct Options
+   * @brief Shape of the generated mazes
+   */
+  struct Options {
+    int width{16};
+    int height{16};
+    /// Keep the maze a tree. A wall follower solves every perfect maze, so
+    /// that rule is never met then.
+    bool perfect{false};
+    /// Probability of removing each remaining inner wall of a multi-path maze
+    double extra_openings{0.05};
+    /// For multi-path mazes, cut the walls around the center off the outer
+    /// wall so that wall followers fail. The carve alone already gives the
+    /// start walls, the hollow center and the single entrance.
+    bool enforce_rules{true};
+  };
+
+  /**
+   * @brief Create a generator
+   * @param seed Seed of the random sequence, the same seed gives the same mazes
+   */
+  explicit MazeGenerator(std::uint64_t seed = 0) : rng_{seed} {}
+
+  /**
+   * @brief Generate one maze
+   * @param options Size and kind of maze
+   * @return The maze, mouse at the start
+   * @throw std::invalid_argument if the maze is smaller than 3 x 3
+   */
+  MazeSimulator generate(const Options &options);
+
+private:
+  // Walls are kept per cell like MazeSimulator::pack(): bit i for Direction(i)
+  void carve();
+  void open(int x, int y, Direction direction) noexcept;
+  // walls the rules fix: the outer wall, east of the start, around the center
+  [[nodiscard]] bool is_protected(int x, int y, Direction direction) const noexcept;
+  bool detach_center();
+  void open_extra(double probability);
+  std::uint32_t random_below(std::uint32_t bound);
+  [[nodiscard]] bool in_center(int x, int y) const noexcept {
+    return x >= center_x0_ && x <= center_x1_ && y >= center_y0_ && y <= center_y1_;
+  }
+  // stacks and queues hold coordinates as x | y << 16
+  static int pack_xy(int x, int y) noexcept { return x | (y << 16); }
+
+  std::mt19937_64 rng_;
+  int width_{0};
+  int height_{0};
+  int center_x0_{0};
+  int center_x1_{0};
+  int center_y0_{0};
+  int center_y1_{0};
+  std::vector<std::uint8_t> walls_;
+  std::vector<std::uint8_t> visited_;
+  std::vector<int> stack_;
+  std::vector<int> parents_; // per post
+  std::vector<int> queue_;
+  std::vector<std::uint8_t> packed_;
+}; // class MazeGenerator
+
+} // namespace micro_mouse
@@ -0,0 +1,357 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "maze_api.hpp"
+#include "maze_types.hpp"
+
+namespace micro_mouse {
+
+/// Maze dimension only known at run time
+inline constexpr int kDynamic = -1;
+/// Side of a competition maze, the size the templates are specialized for
+inline constexpr int kClassicSize = 16;
+
+/**
+ * @brief One value per cell of a W x H maze
+ *
+ * A std::array when the dimensions are compile-time constants, a std::vector
+ * sized at run time when they are kDynamic.
+ */
+template <typename T, int W, int H>
+using CellArray = std::conditional_t<W == kDynamic, std::vector<T>,
+                                     std::array<T, static_cast<std::size_t>(W == kDynamic ? 0 : W * H)>>;
+
+/**
+ * @brief Set every cell of a CellArray to @p value, sizing a std::vector to
+ * @p count cells first
+ */
+template <typename T, std::size_t N, typename V>
+void fill_cells(std::array<T, N> &cells, std::size_t /*count*/, const V &value) {
+  cells.fill(static_cast<T>(value));
+}
+template <typename T, typename V>
+void fill_cells(std::vector<T> &cells, std::size_t count, const V &value) {
+  cells.assign(count, static_cast<T>(value));
+}
+
+/**
+ * @brief What the mouse knows about the walls of the maze
+ *
+ * Each wall shared by two cells is stored once, as one bit: the east wall of
+ * cell i lives in the east planes, its north wall in the north planes, with
+ * cells indexed row-major (i = y * width + x). A "known" plane records which
+ * walls have been observed and a "present" plane which of those exist. West
+ * and south walls are read from the neighbouring cell, and the outer boundary
+ * is always known. A 16x16 maze takes 4 x 32 bytes.
+ *
+ * W and H fix the dimensions at compile time: the planes are then a
+ * std::array, and indexing and boundary tests fold into constants and
+ * shifts. BasicMazeMap<> (MazeMap) takes them at run time instead; both
+ * lay the planes out identically.
+ */
+template <int W = kDynamic, int H = kDynamic>
+class BasicMazeMap {
+  static_assert((W == kDynamic) == (H == kDynamic), "width and height must both be fixed or both be dynamic");
+  static_assert(W == kDynamic || (W > 0 && H > 0), "fixed maze dimensions must be positive");
+
+public:
+  /// true when the dimensions are compile-time constants
+  static constexpr bool kFixed = W != kDynamic;
+
+  /**
+   * @brief Bit planes of the map
+   */
+  enum class Plane { EAST_KNOWN, EAST_PRESENT, NORTH_KNOWN, NORTH_PRESENT };
+
+  /**
+   * @brief Create a map where only the outer boundary is known
+   * @param width Width of the maze in cells
+   * @param height Height of the maze in cells
+   * @throw std::invalid_argument if a dimension is not positive, or does not
+   * match W and H
+   */
+  explicit BasicMazeMap(int width = kFixed ? W : kClassicSize, int height = kFixed ? H : kClassicSize);
+
+  /**
+   * @brief Copy the walls of a map with other compile-time dimensions
+   * @throw std::invalid_argument if the dimensions do not fit W and H
+   */
+  template <int W2, int H2>
+  explicit BasicMazeMap(const BasicMazeMap<W2, H2> &other);
+
+  [[nodiscard]] int get_width() const noexcept {
+    if constexpr (kFixed) {
+      return W;
+    } else {
+      return width_;
+    }
+  }
+  [[nodiscard]] int get_height() const noexcept {
+    if constexpr (kFixed) {
+      return H;
+    } else {
+      return height_;
+    }
+  }
+  [[nodiscard]] int get_cell_count() const noexcept { return get_width() * get_height(); }
+  [[nodiscard]] int index(int x, int y) const noexcept { return y * get_width() + x; }
+  [[nodiscard]] bool contains(int x, int y) const noexcept {
+    return x >= 0 && y >= 0 && x < get_width() && y < get_height();
+  }
+
+  /**
+   * @brief Record an observation of a wall
+   * @param present true if the wall exists, false if the side is open
+   * @return true if the map changed
+   */
+  bool set_wall(int x, int y, Direction direction, bool present = true);
+
+  /**
+   * @brief Check for a wall known to exist
+   * @return true if the wall has been observed, or lies on the boundary
+   */
+  [[nodiscard]] bool has_wall(int x, int y, Direction direction) const noexcept;
+
+  /**
+   * @brief Check whether a wall has been observed, present or not
+   */
+  [[nodiscard]] bool is_known(int x, int y, Direction direction) const noexcept;
+
+  /**
+   * @brief Forget every observation except the outer boundary
+   */
+  void reset();
+
+  /**
+   * @brief Replace every observation with the raw words of another map
+   * @param words 4 planes of get_words_per_plane() words, in Plane order
+   * @throw std::invalid_argument if @p words has the wrong size
+   */
+  void set_words(const std::vector<std::uint64_t> &words);
+
+  /**
+   * @brief Mirror wall updates to MazeControlAPI::set_wall / clear_wall
+   * @param enabled true to draw the walls in the simulator as they are set
+   */
+  void set_visualize(bool enabled) noexcept { visualize_ = enabled; }
+
+  /**
+   * @brief Draw every inner wall known to exist with MazeControlAPI::set_wall
+   */
+  void draw() const;
+
+  /**
+   * @brief Raw words of one plane, bit i for cell i
+   */
+  [[nodiscard]] const std::uint64_t *get_plane(Plane plane) const noexcept {
+    return words_.data() + static_cast<std::size_t>(plane) * get_words_per_plane();
+  }
+  [[nodiscard]] std::size_t get_words_per_plane() const noexcept {
+    if constexpr (kFixed) {
+      return kFixedWords;
+    } else {
+      return words_per_plane_;
+    }
+  }
+
+private:
+  static constexpr std::size_t kFixedWords = kFixed ? (static_cast<std::size_t>(W * H) + 63) / 64 : 0;
+
+  [[nodiscard]] static constexpr Plane present_plane(Plane known) noexcept {
+    return static_cast<Plane>(static_cast<int>(known) + 1);
+  }
+  // Plane and cell index holding the wall on an inner side of (x, y)
+  void locate(int x, int y, Direction direction, Plane &known, int &cell) const noexcept;
+  // true for sides on the outer boundary, and for cells outside the maze
+  [[nodiscard]] bool on_boundary(int x, int y, Direction direction) const noexcept {
+    return !contains(x, y) || !contains(x + dx(direction), y + dy(direction));
+  }
+  [[nodiscard]] bool test(Plane plane, int cell) const noexcept {
+    return (get_plane(plane)[cell >> 6] >> (cell & 63)) & 1U;
+  }
+  void assign(Plane plane, int cell, bool value) noexcept;
+  void close_boundary() noexcept;
+
+  int width_;
+  int height_;
+  std::size_t words_per_plane_;
+  std::conditional_t<kFixed, std::array<std::uint64_t, 4 * kFixedWords>, std::vector<std::uint64_t>> words_{};
+  bool visualize_{false};
+}; // class BasicMazeMap
+
+/// Map whose dimensions are read from the simulator at run time
+using MazeMap = BasicMazeMap<>;
+/// Map of a 16x16 competition maze
+using ClassicMazeMap = BasicMazeMap<kClassicSize, kClassicSize>;
+
+template <int W, int H>
+BasicMazeMap<W, H>::BasicMazeMap(int width, int height)
+    : width_{width}, height_{height},
+      words_per_plane_{(static_cast<std::size_t>(std::max(width * height, 0)) + 63) / 64} {
+  if (width <= 0 || height <= 0) {
+    throw std::invalid_argument("maze dimensions must be positive");
+  }
+  if constexpr (kFixed) {
+    if (width != W || height != H) {
+      throw std::invalid_argument("maze dimensions do not match the map type");
+    }
+  } else {
+    words_.resize(4 * words_per_plane_);
+  }
+  reset();
+}
+
+template <int W, int H>
+template <int W2, int H2>
+BasicMazeMap<W, H>::BasicMazeMap(const BasicMazeMap<W2, H2> &other)
+    : BasicMazeMap(other.get_width(), other.get_height()) {
+  // same dimensions, so the same plane layout
+  const std::uint64_t *words = other.get_plane(BasicMazeMap<W2, H2>::Plane::EAST_KNOWN);
+  std::copy(words, words + words_.size(), words_.begin());
+}
+
+template <int W, int H>
+void BasicMazeMap<W, H>::reset() {
+  std::fill(words_.begin(), words_.end(), 0);
+  close_boundary();
+}
+
+template <int W, int H>
+void BasicMazeMap<W, H>::set_words(const std::vector<std::uint64_t> &words) {
+  if (words.size() != words_.size()) {
+    throw std::invalid_argument("wall planes do not match the maze dimensions");
+  }
+  std::copy(words.begin(), words.end(), words_.begin());
+  // a wall cannot be present without being known; bits past the last cell
+  // and the boundary are not trusted from the source
+  const std::size_t per_plane = get_words_per_plane();
+  for (std::size_t i = 0; i < per_plane; ++i) {
+    words_[per_plane + i] &= words_[i];
+    words_[3 * per_plane + i] &= words_[2 * per_plane + i];
+  }
+  const int cells = get_cell_count();
+  for (int plane = 0; plane < 4; ++plane) {
+    for (int cell = cells; cell < static_cast<int>(64 * per_plane); ++cell) {
+      assign(static_cast<Plane>(plane), cell, false);
+    }
+  }
+  close_boundary();
+  if (visualize_) {
+    draw();
+  }
+}
+
+template <int W, int H>
+void BasicMazeMap<W, H>::draw() const {
+  for (int y = 0; y < get_height(); ++y) {
+    for (int x = 0; x < get_width(); ++x) {
+      if (x + 1 < get_width() && has_wall(x, y, Direction::EAST)) {
+        MazeControlAPI::set_wall(x, y, to_char(Direction::EAST));
+      }
+      if (y + 1 < get_height() && has_wall(x, y, Direction::NORTH)) {
+        MazeControlAPI::set_wall(x, y, to_char(Direction::NORTH));
+      }
+    }
+  }
+}
+
+template <int W, int H>
+void BasicMazeMap<W, H>::close_boundary() noexcept {
+  for (int y = 0; y < get_height(); ++y) {
+    assign(Plane::EAST_KNOWN, index(get_width() - 1, y), true);
+    assign(Plane::EAST_PRESENT, index(get_width() - 1, y), true);
+  }
+  for (int x = 0; x < get_width(); ++x) {
+    assign(Plane::NORTH_KNOWN, index(x, get_height() - 1), true);
+    assign(Plane::NORTH_PRESENT, index(x, get_height() - 1), true);
+  }
+}
+
+template <int W, int H>
+void BasicMazeMap<W, H>::assign(Plane plane, int cell, bool value) noexcept {
+  std::uint64_t &word =
+      words_[static_cast<std::size_t>(plane) * get_words_per_plane() + static_cast<std::size_t>(cell >> 6)];
+  const std::uint64_t mask = std::uint64_t{1} << (cell & 63);
+  word = value ? (word | mask) : (word & ~mask);
+}
+
+template <int W, int H>
+void BasicMazeMap<W, H>::locate(int x, int y, Direction direction, Plane &known, int &cell) const noexcept {
+  switch (direction) {
+  case Direction::EAST:
+    known = Plane::EAST_KNOWN;
+    break;
+  case Direction::NORTH:
+    known = Plane::NORTH_KNOWN;
+    break;
+  case Direction::WEST:
+    known = Plane::EAST_KNOWN;
+    --x;
+    break;
+  case Direction::SOUTH:
+    known = Plane::NORTH_KNOWN;
+    --y;
+    break;
+  }
+  cell = index(x, y);
+}
+
+template <int W, int H>
+bool BasicMazeMap<W, H>::set_wall(int x, int y, Direction direction, bool present) {
+  if (on_boundary(x, y, direction)) {
+    // the outer boundary is fixed
+    return false;
+  }
+  Plane known{};
+  int cell = 0;
+  locate(x, y, direction, known, cell);
+  const bool was_known = test(known, cell);
+  const bool was_present = test(present_plane(known), cell);
+  if (was_known && was_present == present) {
+    return false;
+  }
+  assign(known, cell, true);
+  assign(present_plane(known), cell, present);
+  if (visualize_) {
+    if (present) {
+      MazeControlAPI::set_wall(x, y, to_char(direction));
+    } else if (was_present) {
+      MazeControlAPI::clear_wall(x, y, to_char(direction));
+    }
+  }
+  return true;
+}
+
+template <int W, int H>
+bool BasicMazeMap<W, H>::has_wall(int x, int y, Direction direction) const noexcept {
+  if (on_boundary(x, y, direction)) {
+    return true;
+  }
+  Plane known{};
+  int cell = 0;
+  locate(x, y, direction, known, cell);
+  return test(present_plane(known), cell);
+}
+
+template <int W, int H>
+bool BasicMazeMap<W, H>::is_known(int x, int y, Direction direction) const noexcept {
+  if (on_boundary(x, y, direction)) {
+    return true;
+  }
+  Plane known{};
+  int cell = 0;
+  locate(x, y, direction, known, cell);
+  return test(known, cell);
+}
+
+// compiled once in maze_map.cpp
+extern template class BasicMazeMap<kClassicSize, kClassicSize>;
+extern template class BasicMazeMap<kDynamic, kDynamic>;
+
+} // namespace micro_mouse
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "maze_types.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Headless, in-process stand-in for the mms simulator
+ *
+ * Holds the true walls of a maze and the pose of the mouse, and answers the
+ * same text commands that MazeControlAPI writes to the mms simulator. The
+ * model can also be driven directly through its member functions, which is
+ * what batch runs use to avoid any serialization.
+ */
+class MazeSimulator {
+public:
+  /**
+   * @brief Counters collected while the simulator is running
+   */
+  struct Stats {
+    std::uint64_t commands{0};    // protocol lines and mouse commands handled
+    std::uint64_t wall_queries{0};
+    std::uint64_t moves{0};       // move commands, whatever their distance
+    std::uint64_t cells_moved{0};
+    std::uint64_t turns{0};
+    std::uint64_t crashes{0};
+    std::uint64_t episodes{0};    // completed resets
+  };
+
+  /**
+   * @brief Build an enclosed maze without inner walls
+   * @param width Width of the maze in cells
+   * @param height Height of the maze in cells
+   */
+  MazeSimulator(int width = 16, int height = 16);
+
+  /**
+   * @brief Load a maze file in the mms "map" (ASCII art) or "num" format
+   * @param path Path to the maze file
+   * @return The loaded simulator, mouse at (0, 0) facing north
+   * @throw std::runtime_error if the file cannot be read or parsed
+   */
+  static MazeSimulator from_file(const std::string &path);
+
+  /**
+   * @brief Parse the content of a maze file
+   * @param text Content in the mms "map" or "num" format
+   * @throw std::runtime_error if the content cannot be parsed
+   */
+  static MazeSimulator from_text(std::string_view text);
+
+  /**
+   * @brief Write the maze in the mms "map" format, with 'o' posts
+   */
+  [[nodiscard]] std::string to_text() const;
+
+  /**
+   * @brief Build a maze from walls packed by pack()
+   * @param width Width of the maze in cells
+   * @param height Height of the maze in cells
+   * @param packed get_packed_size() bytes, 4 bits per cell
+   */
+  static MazeSimulator from_packed(int width, int height, const std::uint8_t *packed);
+
+  /**
+   * @brief Pack the walls, 4 bits per cell (bit i for Direction(i)), two
+   * cells per byte with the lower index in the low nibble
+   * @param packed Receives get_packed_size() bytes
+   */
+  void pack(std::uint8_t *packed) const noexcept;
+  [[nodiscard]] std::size_t get_packed_size() const noexcept { return (walls_.size() + 1) / 2; }
+
+  /**
+   * @brief 64-bit FNV-1a hash of the dimensions and walls
+   *
+   * Equal for equal mazes; tells a checkpoint learned in another maze apart.
+   */
+  [[nodiscard]] std::uint64_t get_fingerprint() const noexcept;
+
+  [[nodiscard]] int get_width() const noexcept { return width_; }
+  [[nodiscard]] int get_height() const noexcept { return height_; }
+  [[nodiscard]] const Pose &get_pose() const noexcept { return pose_; }
+  [[nodiscard]] const Stats &get_stats() const noexcept { return stats_; }
+  void reset_stats() noexcept { stats_ = Stats{}; }
+
+  /**
+   * @brief Check the true wall on one side of a cell
+   * @return true for a wall, or if (x, y) lies outside the maze
+   */
+  [[nodiscard]] bool has_wall(int x, int y, Direction direction) const noexcept;
+
+  /**
+   * @brief Add or remove a wall, keeping both adjacent cells consistent
+   */
+  void set_wall(int x, int y, Direction direction, bool present);
+
+  /**
+   * @brief Check whether (x, y) is one of the center goal cells
+   */
+  [[nodiscard]] bool is_goal(int x, int y) const noexcept;
+
+  // Mouse commands, with the semantics of the mms simulator
+  bool wall_front() noexcept;
+  bool wall_right() noexcept;
+  bool wall_left() noexcept;
+
+  /**
+   * @brief Move forward, stopping in front of the first wall
+   * @param distance Number of cells to move
+   * @return false if the mouse crashed into a wall
+   */
+  bool move_forward(int distance = 1);
+  void turn_right() noexcept;
+  void turn_left() noexcept;
+
+  /**
+   * @brief Simulate a press of the reset button
+   */
+  void request_reset() noexcept { reset_requested_ = true; }
+  [[nodiscard]] bool was_reset() const noexcept { return reset_requested_; }
+
+  /**
+   * @brief Put the mouse back at the start and clear the reset flag
+   */
+  void ack_reset() noexcept;
+
+  /**
+   * @brief Check the reset flag, counted as a mouse command
+   */
+  bool poll_reset() noexcept;
+
+  /**
+   * @brief Execute one line of the mms text protocol
+   * @param line Command without the trailing newline
+   * @param reply Receives the reply, without newline; cleared first
+   * @return true if the command expects a reply
+   */
+  bool handle(std::string_view line, std::string &reply);
+
+private:
+  [[nodiscard]] std::size_t index(int x, int y) const noexcept {
+    return static_cast<std::size_t>(y) * static_cast<std::size_t>(width_) +
+           static_cast<std::size_t>(x);
+  }
+  [[nodiscard]] bool inside(int x, int y) const noexcept {
+    return x >= 0 && y >= 0 && x < width_ && y < height_;
+  }
+  bool sense(Direction direction) noexcept;
+
+  int width_;
+  int height_;
+  // One bit per side of each cell, bit i set for a wall towards Direction(i)
+  std::vector<std::uint8_t> walls_;
+  Pose pose_;
+  bool reset_requested_{false};
+  Stats stats_;
+}; // class MazeSimulator
+
+} // namespace micro_mouse
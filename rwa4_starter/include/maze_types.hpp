@@ -0,0 +1,104 @@
+#pragma once
+
+namespace micro_mouse {
+
+/**
+ * @enum Direction
+ * @brief Absolute headings in the maze, in clockwise order
+ *
+ * North is towards increasing y, east towards increasing x, which matches the
+ * coordinate system used by the mms simulator.
+ */
+enum class Direction {
+  NORTH, // +y
+  EAST,  // +x
+  SOUTH, // -y
+  WEST   // -x
+};
+
+/**
+ * @brief Heading obtained after a 90 degree clockwise turn
+ * @param direction Current heading
+ * @return The heading on the right of @p direction
+ */
+[[nodiscard]] constexpr Direction turn_right(Direction direction) noexcept {
+  return static_cast<Direction>((static_cast<int>(direction) + 1) & 3);
+}
+
+/**
+ * @brief Heading obtained after a 90 degree counter-clockwise turn
+ * @param direction Current heading
+ * @return The heading on the left of @p direction
+ */
+[[nodiscard]] constexpr Direction turn_left(Direction direction) noexcept {
+  return static_cast<Direction>((static_cast<int>(direction) + 3) & 3);
+}
+
+/**
+ * @brief Opposite heading
+ * @param direction Current heading
+ * @return The heading behind @p direction
+ */
+[[nodiscard]] constexpr Direction opposite(Direction direction) noexcept {
+  return static_cast<Direction>((static_cast<int>(direction) + 2) & 3);
+}
+
+/**
+ * @brief X offset of one step along @p direction
+ */
+[[nodiscard]] constexpr int dx(Direction direction) noexcept {
+  return direction == Direction::EAST ? 1 : direction == Direction::WEST ? -1 : 0;
+}
+
+/**
+ * @brief Y offset of one step along @p direction
+ */
+[[nodiscard]] constexpr int dy(Direction direction) noexcept {
+  return direction == Direction::NORTH ? 1 : direction == Direction::SOUTH ? -1 : 0;
+}
+
+/**
+ * @brief Character used by the mms protocol for @p direction
+ * @return One of 'n', 'e', 's', 'w'
+ */
+[[nodiscard]] constexpr char to_char(Direction direction) noexcept {
+  constexpr char kChars[] = {'n', 'e', 's', 'w'};
+  return kChars[static_cast<int>(direction)];
+}
+
+/**
+ * @brief Parse a direction character of the mms protocol
+ * @param c One of 'n', 'e', 's', 'w' (upper case is accepted too)
+ * @param direction Output heading, untouched when @p c is not a direction
+ * @return true if @p c was a valid direction character
+ */
+constexpr bool from_char(char c, Direction &direction) noexcept {
+  switch (c) {
+  case 'n': case 'N': direction = Direction::NORTH; return true;
+  case 'e': case 'E': direction = Direction::EAST; return true;
+  case 's': case 'S': direction = Direction::SOUTH; return true;
+  case 'w': case 'W': direction = Direction::WEST; return true;
+  default: return false;
+  }
+}
+
+/**
+ * @struct Cell
+ * @brief Coordinates of a maze cell
+ */
+struct Cell {
+  int x{0};
+  int y{0};
+};
+
+/**
+ * @struct Pose
+ * @brief Cell coordinates and heading of the mouse
+ */
+struct Pose {
+  int x{0};
+  int y{0};
+  Direction heading{Direction::NORTH};
+};
+
+} // namespace micro_mouse
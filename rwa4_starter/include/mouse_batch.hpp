@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "maze_simulator.hpp"
+#include "maze_types.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Many independent mice exploring many mazes in lockstep
+ *
+ * Meant for tuning exploration heuristics over thousands of runs in one
+ * process. Every mouse follows the rules a single mouse sees through
+ * MazeControlAPI: it starts at (0, 0) facing north, reads the walls on its
+ * left, front and right, turns in quarter turns, moves one cell at a time
+ * and stops on a center cell, as MazeSimulator::is_goal() defines them.
+ *
+ * At each cell, a mouse scores its four neighbours with its own Heuristic
+ * and moves to the best open one; walls it has not seen count as open. The
+ * state of the mice is stored as a structure of arrays: one array per field
+ * (position, heading, counters, weights), one wall map and one visit count
+ * per mouse, laid out one after the other. A step is a few passes over those
+ * arrays: read the walls, gather the scores' inputs, score and pick with
+ * branch-free arithmetic the compiler can vectorize, then move. The mice are
+ * split into contiguous shards, one per thread, which never share a mouse.
+ */
+class MouseBatch {
+public:
+  /**
+   * @brief Weights of the exploration heuristic of one mouse
+   *
+   * The score of a neighbour is minus the weighted sum of its Manhattan
+   * distance to the nearest center cell, the number of times the mouse
+   * entered it and the quarter turns needed to face it. Ties go to the
+   * front, then left, right and back.
+   */
+  struct Heuristic {
+    float distance{1.0f};
+    float visits{2.0f};
+    float turns{0.5f};
+  };
+
+  /// Where a mouse stands
+  enum class State : std::uint8_t {
+    RUNNING,
+    GOAL,   // on a center cell
+    STUCK   // walled in at the start
+  };
+
+  /**
+   * @param threads Threads used by run(), 0 for one per hardware thread
+   */
+  explicit MouseBatch(unsigned threads = 0);
+
+  /**
+   * @brief Copy the walls of a maze into the batch
+   * @return Index of the maze, for add_mouse()
+   */
+  int add_maze(const MazeSimulator &maze);
+
+  /**
+   * @brief Put a new mouse at the start of a maze
+   * @return Index of the mouse
+   * @throw std::out_of_range if @p maze was not added
+   */
+  int add_mouse(int maze, const Heuristic &heuristic);
+
+  /**
+   * @brief Advance every running mouse by up to @p max_steps moves
+   */
+  void run(std::uint64_t max_steps);
+
+  [[nodiscard]] std::size_t get_mouse_count() const noexcept { return x_.size(); }
+  [[nodiscard]] unsigned get_threads() const noexcept { return threads_; }
+  [[nodiscard]] State get_state(int mouse) const { return state_.at(static_cast<std::size_t>(mouse)); }
+  [[nodiscard]] Pose get_pose(int mouse) const;
+  [[nodiscard]] std::uint32_t get_moves(int mouse) const { return moves_.at(static_cast<std::size_t>(mouse)); }
+  [[nodiscard]] std::uint32_t get_turns(int mouse) const { return turns_.at(static_cast<std::size_t>(mouse)); }
+  [[nodiscard]] std::uint32_t get_wall_queries(int mouse) const {
+    return queries_.at(static_cast<std::size_t>(mouse));
+  }
+
+private:
+  // Run the mice [begin, end) for up to max_steps moves
+  void advance(std::size_t begin, std::size_t end, std::uint64_t max_steps);
+
+  unsigned threads_;
+
+  // per maze: size, and offset of its first cell in cells_ and distances_
+  std::vector<int> maze_width_;
+  std::vector<int> maze_height_;
+  std::vector<std::size_t> maze_offset_;
+  // per maze cell: bit d for a wall towards Direction(d), kGoalBit on a center
+  // cell; Manhattan distance to the nearest center cell
+  std::vector<std::uint8_t> cells_;
+  std::vector<std::uint16_t> distances_;
+
+  // per mouse
+  std::vector<int> maze_;
+  std::vector<int> x_;
+  std::vector<int> y_;
+  std::vector<std::uint8_t> heading_;
+  std::vector<State> state_;
+  std::vector<std::uint32_t> moves_;
+  std::vector<std::uint32_t> turns_;
+  std::vector<std::uint32_t> queries_;
+  std::vector<float> distance_weight_;
+  std::vector<float> visit_weight_;
+  std::vector<float> turn_weight_;
+  // offset of the first cell of the mouse in maps_ and visits_
+  std::vector<std::size_t> map_offset_;
+
+  // per cell of each mouse: walls it saw, bit d as in cells_; cells entered
+  std::vector<std::uint8_t> maps_;
+  std::vector<std::uint16_t> visits_;
+}; // class MouseBatch
+
+} // namespace micro_mouse
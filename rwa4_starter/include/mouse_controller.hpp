@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+
+#include "explorer.hpp"
+#include "maze_api.hpp"
+#include "maze_map.hpp"
+#include "maze_types.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Exploration to the goals and back as a resumable state machine
+ *
+ * Steps an Explorer with BasicExplorer::begin() and answer(), to the goals
+ * and then back to the start, without calling MazeControlAPI: it yields one
+ * StepCommand at a time and waits to be handed the StepReply. The caller
+ * owns the loop, so one thread can drive many controllers, each against its
+ * own backend, and a controller can sit in an event loop between a command
+ * and its reply. See MouseScheduler.
+ *
+ * The commands are the ones Explorer::explore() sends, to the goals and then
+ * with the start as goal, so both follow the same route.
+ */
+class MouseController {
+public:
+  /// Where the controller stands
+  enum class Phase {
+    SEARCH,  // heading for the goals
+    RETURN,  // goal reached, heading back to the start
+    DONE,    // back at the start
+    FAILED   // walled off or out of moves
+  };
+
+  /**
+   * @brief Create a controller for a maze of the given size, at the start
+   * @param width Width of the maze in cells
+   * @param height Height of the maze in cells
+   * @param max_moves Give up after this many moves, both ways
+   */
+  MouseController(int width, int height, std::uint64_t max_moves = std::numeric_limits<std::uint64_t>::max());
+
+  /**
+   * @brief Check whether the controller stopped yielding commands
+   */
+  [[nodiscard]] bool is_finished() const noexcept { return phase_ == Phase::DONE || phase_ == Phase::FAILED; }
+
+  /**
+   * @brief Command to send next, valid until answer()
+   */
+  [[nodiscard]] const StepCommand &get_command() const noexcept { return explorer_.get_command(); }
+
+  /**
+   * @brief Hand over the replies to get_command() and compute the next one
+   * @throw std::logic_error if the controller is finished
+   */
+  void answer(const StepReply &reply);
+
+  /// Explorer taking the steps, e.g. to set pruning before the first answer()
+  [[nodiscard]] Explorer &get_explorer() noexcept { return explorer_; }
+  [[nodiscard]] Phase get_phase() const noexcept { return phase_; }
+  [[nodiscard]] const MazeMap &get_map() const noexcept { return explorer_.get_map(); }
+  [[nodiscard]] const Pose &get_pose() const noexcept { return explorer_.get_pose(); }
+  [[nodiscard]] std::uint64_t get_moves() const noexcept { return explorer_.get_stats().moves; }
+  [[nodiscard]] std::uint64_t get_turns() const noexcept { return explorer_.get_stats().turns; }
+  [[nodiscard]] std::uint64_t get_wall_queries() const noexcept { return explorer_.get_stats().wall_queries; }
+
+private:
+  // Start the next exploration until one has a step to send, or finish
+  void next_phase();
+
+  Explorer explorer_;
+  Phase phase_{Phase::SEARCH};
+  std::uint64_t max_moves_;
+}; // class MouseController
+
+} // namespace micro_mouse
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "maze_backend.hpp"
+#include "mouse_controller.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Drives many MouseControllers from one thread
+ *
+ * Each mouse pairs a controller with the backend of its own maze. A round
+ * posts the pending command of every running mouse, then collects the
+ * replies in the same order and hands them over, so backends with a round
+ * trip have all their steps in flight at once. In-process backends, such as
+ * DirectBackend, run each step when its reply is collected. Mice finish
+ * independently; a round only visits the ones still running.
+ */
+class MouseScheduler {
+public:
+  /**
+   * @brief Add a mouse
+   * @param controller Controller of the mouse, not owned
+   * @param backend Backend connected to its maze, not owned, used by this
+   * mouse alone
+   * @return Index of the mouse
+   */
+  int add(MouseController &controller, MazeBackend &backend);
+
+  /**
+   * @brief Run one step of every running mouse
+   * @return false once every mouse is finished
+   * @throw std::runtime_error if a backend reports a failed move
+   */
+  bool run_round();
+
+  /**
+   * @brief Run rounds until every mouse is finished
+   */
+  void run();
+
+  [[nodiscard]] std::size_t get_mouse_count() const noexcept { return mice_.size(); }
+  [[nodiscard]] std::uint64_t get_rounds() const noexcept { return rounds_; }
+  [[nodiscard]] std::uint64_t get_steps() const noexcept { return steps_; }
+
+private:
+  struct Mouse {
+    MouseController *controller;
+    MazeBackend *backend;
+  };
+
+  std::vector<Mouse> mice_;
+  // indices of the mice still running, in the order they were added
+  std::vector<std::size_t> running_;
+  std::uint64_t rounds_{0};
+  std::uint64_t steps_{0};
+}; // class MouseScheduler
+
+} // namespace micro_mouse
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "flood_fill.hpp"
+#include "maze_map.hpp"
+#include "maze_types.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @struct Segment
+ * @brief One command of a compiled path: a turn in place or a straight
+ */
+struct Segment {
+  enum class Kind { FORWARD, TURN_LEFT, TURN_RIGHT, TURN_AROUND };
+
+  Kind kind{Kind::FORWARD};
+  int cells{0}; // length of a FORWARD segment, 0 for turns
+};
+
+/**
+ * @brief Compile the descent of a distance field into straights and turns
+ *
+ * Follows next_direction() from @p start until the goal and merges
+ * consecutive moves along the same heading into one FORWARD segment, so a
+ * straight costs a single move_forward(n) command.
+ * @param map Walls used by the last planner.compute()
+ * @param planner Planner holding the distance field to follow
+ * @param start Cell and heading of the mouse
+ * @param goal Goal to head for, -1 for the nearest one
+ * @return The segments, empty if the goal cannot be reached
+ */
+template <int W, int H>
+std::vector<Segment> compile_path(const BasicMazeMap<W, H> &map, const BasicFloodFillPlanner<W, H> &planner, Pose start,
+                                  int goal = -1);
+
+/**
+ * @brief Turn needed to go from one heading to another
+ * @return A turn segment, or a FORWARD segment of 0 cells if none is needed
+ */
+Segment turn_between(Direction from, Direction to) noexcept;
+
+template <int W, int H>
+std::vector<Segment> compile_path(const BasicMazeMap<W, H> &map, const BasicFloodFillPlanner<W, H> &planner, Pose start,
+                                  int goal) {
+  std::vector<Segment> segments;
+  Pose pose = start;
+  Direction direction = pose.heading;
+  // every step strictly decreases the distance, so this terminates
+  while (planner.next_direction(map, pose, direction, goal)) {
+    const Segment turn = turn_between(pose.heading, direction);
+    if (turn.kind != Segment::Kind::FORWARD) {
+      segments.push_back(turn);
+      pose.heading = direction;
+    }
+    if (segments.empty() || segments.back().kind != Segment::Kind::FORWARD) {
+      segments.push_back({Segment::Kind::FORWARD, 0});
+    }
+    ++segments.back().cells;
+    pose.x += dx(direction);
+    pose.y += dy(direction);
+  }
+  const std::uint16_t left = goal < 0 ? planner.get_distance(pose.x, pose.y)
+                                      : planner.get_goal_distance(goal, pose.x, pose.y);
+  if (left != 0) {
+    segments.clear();
+  }
+  return segments;
+}
+
+} // namespace micro_mouse
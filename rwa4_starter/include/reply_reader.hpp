@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+namespace micro_mouse {
+
+/**
+ * @brief Allocation-free tokenizer for simulator replies
+ *
+ * Reads raw bytes from a file descriptor into a fixed buffer and hands out
+ * whitespace separated tokens as views into that buffer. Values are decoded
+ * without std::string temporaries or locale-aware stream extraction.
+ */
+class ReplyReader {
+public:
+  /**
+   * @brief Create a reader on a file descriptor
+   * @param fd Descriptor to read from (not owned), stdin by default
+   */
+  explicit ReplyReader(int fd = 0) noexcept : fd_{fd} {}
+
+  ReplyReader(const ReplyReader &) = delete;
+  ReplyReader &operator=(const ReplyReader &) = delete;
+
+  /**
+   * @brief Read the next token
+   * @return View into the internal buffer, valid until the next read; empty
+   * at end of input
+   */
+  std::string_view next_token();
+
+  /**
+   * @brief Read a "true"/"false" reply
+   * @return true only for a "true" token
+   */
+  bool read_bool() { return next_token() == "true"; }
+
+  /**
+   * @brief Read an integer reply
+   * @return The decimal value, parsed like atoi (0 when not a number)
+   */
+  int read_int();
+
+private:
+  // Read more input after the unread bytes; false at end of input or error
+  bool fill();
+
+  static constexpr std::size_t kCapacity = 4096;
+
+  int fd_;
+  char buffer_[kCapacity];
+  std::size_t begin_{0}; // first unread byte
+  std::size_t end_{0};   // one past the last valid byte
+}; // class ReplyReader
+
+} // namespace micro_mouse
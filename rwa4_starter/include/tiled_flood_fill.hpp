@@ -0,0 +1,154 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "flood_fill.hpp"
+#include "maze_map.hpp"
+#include "maze_types.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Cache-blocked, multi-threaded flood fill for very large mazes
+ *
+ * A plain queue BFS over a 1024x1024 maze jumps around a multi-megabyte
+ * distance array and spends most of its time waiting on memory. This planner
+ * cuts the maze into square tiles (64x64 cells by default, 16 KiB of
+ * distances plus 4 KiB of wall bits, so one tile stays in L1/L2) stored one
+ * after the other, and computes the field in rounds:
+ *
+ * 1. every tile with new seed cells runs an exact BFS inside itself, never
+ *    crossing its edges, and publishes the distances of its edge cells;
+ * 2. every tile next to a changed edge pulls the published distances across
+ *    its open edge walls, and the cells they improve seed the next round.
+ *
+ * Within a phase each tile writes only its own cells, so the tiles of a
+ * phase run in parallel on a small pool of threads without locks. Rounds
+ * stop when no tile changes. The result is the exact breadth-first distance
+ * to the nearest goal, whatever the tile size or thread count.
+ */
+class TiledFloodFillPlanner {
+public:
+  /// Distance of cells that cannot reach the goal
+  static constexpr std::uint32_t kUnreachable = 0xFFFFFFFF;
+
+  /**
+   * @brief Work done by the last compute()
+   */
+  struct Stats {
+    std::uint64_t rounds{0};     // relax/exchange rounds
+    std::uint64_t tile_passes{0}; // tile BFS runs, over all rounds
+    std::uint64_t expansions{0}; // cells expanded, over all tile BFS runs
+  };
+
+  /**
+   * @param tile_size Side of a tile in cells, a power of two from 8 to 256
+   * @param threads Threads used by compute(), 0 for one per hardware thread
+   * @throw std::invalid_argument if @p tile_size is not supported
+   */
+  explicit TiledFloodFillPlanner(int tile_size = 64, unsigned threads = 1);
+
+  /**
+   * @brief Select how far ahead of the lowest seed a tile may run
+   *
+   * Each round only relaxes the tiles whose lowest seed is within @p window
+   * of the lowest seed of all: smaller windows redo less work on tiles the
+   * wavefront later reaches by a shorter way, larger ones give the threads
+   * more tiles per round. Defaults to the tile size.
+   */
+  void set_window(std::uint32_t window) noexcept { window_ = window; }
+
+  /**
+   * @brief Select the wall policy of the next compute() calls
+   */
+  void set_wall_policy(FloodFillBase::WallPolicy policy) noexcept { policy_ = policy; }
+
+  /**
+   * @brief Select the thread count of the next compute() calls
+   * @param threads Thread count, 0 for one per hardware thread
+   */
+  void set_threads(unsigned threads) noexcept;
+
+  /**
+   * @brief Recompute the distance of every cell to the nearest goal
+   * @param map Walls known so far
+   * @param goals Goal cells, any number of them
+   */
+  void compute(const MazeMap &map, const std::vector<Cell> &goals);
+
+  /**
+   * @brief Distance from (x, y) to the nearest goal, kUnreachable if none
+   */
+  [[nodiscard]] std::uint32_t get_distance(int x, int y) const noexcept {
+    return distances_[storage_index(x, y)];
+  }
+
+  /**
+   * @brief Distance of every cell to the nearest goal, indexed like the MazeMap
+   */
+  [[nodiscard]] const std::vector<std::uint32_t> &get_distances() const;
+
+  /**
+   * @brief Best direction to leave a cell, see FloodFillPlanner::next_direction
+   *
+   * Uses the walls and wall policy of the last compute().
+   */
+  bool next_direction(const Pose &pose, Direction &direction) const noexcept;
+
+  [[nodiscard]] int get_tile_size() const noexcept { return tile_; }
+  [[nodiscard]] unsigned get_threads() const noexcept { return threads_; }
+  [[nodiscard]] const Stats &get_stats() const noexcept { return stats_; }
+
+private:
+  struct Seed {
+    std::uint32_t distance;
+    std::uint32_t cell; // index inside the tile
+  };
+
+  [[nodiscard]] std::size_t storage_index(int x, int y) const noexcept {
+    const auto tile = static_cast<std::size_t>((y >> shift_) * tiles_x_ + (x >> shift_));
+    return (tile << (2 * shift_)) + static_cast<std::size_t>(((y & (tile_ - 1)) << shift_) + (x & (tile_ - 1)));
+  }
+  // Index inside a tile of the k-th cell along one edge
+  [[nodiscard]] int edge_cell(Direction side, int k) const noexcept;
+  // Tile across one side of a tile, -1 past the maze
+  [[nodiscard]] int neighbour_tile(int tile, Direction side) const noexcept;
+
+  void build_tile(const MazeMap &map, int tile);
+  // BFS inside the tile from its seeds; returns the cells expanded
+  std::uint64_t relax_tile(int tile);
+  // Pull changed edges of the neighbours; returns true if it got seeds
+  bool exchange_tile(int tile);
+
+  int tile_;
+  int shift_;
+  unsigned threads_{1};
+  std::uint32_t window_;
+  FloodFillBase::WallPolicy policy_{FloodFillBase::WallPolicy::OPTIMISTIC};
+  int width_{0};
+  int height_{0};
+  int tiles_x_{0};
+  int tiles_y_{0};
+  // tile-major: the tile_ x tile_ cells of tile 0, then of tile 1, ...
+  std::vector<std::uint32_t> distances_;
+  // per cell: bit d when open towards Direction(d), bit 4 + d when that
+  // neighbour is also in the tile
+  std::vector<std::uint8_t> open_;
+  // per tile: edge distances published by the last relax, 4 sides of tile_
+  std::vector<std::uint32_t> edges_;
+  // per tile: bit d when the edge on side d changed in the last relax
+  std::vector<std::uint8_t> changed_;
+  std::vector<std::vector<Seed>> seeds_;
+  // per tile: lowest distance among its seeds, kUnreachable without seeds
+  std::vector<std::uint32_t> lowest_seed_;
+  // scratch of compute(): 1 while a tile waits with seeds, round stamp of
+  // each tile, to list it once per round
+  std::vector<std::uint8_t> listed_;
+  std::vector<std::uint64_t> stamps_;
+  Stats stats_;
+  // row-major distances, unpacked on demand
+  mutable std::vector<std::uint32_t> row_major_;
+  mutable bool unpacked_{false};
+}; // class TiledFloodFillPlanner
+
+} // namespace micro_mouse
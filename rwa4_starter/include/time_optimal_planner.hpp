@@ -0,0 +1,178 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "flood_fill.hpp"
+#include "maze_map.hpp"
+#include "maze_types.hpp"
+#include "path.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @struct RunCostModel
+ * @brief Timing of the mouse used to rank speed-run paths
+ *
+ * Straights follow a trapezoidal speed profile from rest to rest, turns are
+ * done in place at a fixed cost.
+ */
+struct RunCostModel {
+  double cell_length{0.18};    // m
+  double max_speed{2.0};       // m/s
+  double acceleration{4.0};    // m/s^2
+  double turn_time{0.25};      // s, 90 degree turn in place
+  double turn_around_time{0.4}; // s, 180 degree turn in place
+};
+
+/**
+ * @brief Fastest-time planner over (cell, heading) states
+ *
+ * Unlike a cell-count flood fill, a path with fewer, longer straights wins
+ * even when it is a few cells longer. States are a cell and a heading; edges
+ * are turns in place and straights of any length, whose times come from a
+ * lookup table filled once from the RunCostModel. Dijkstra's algorithm from
+ * the start pose gives the fastest route to the goal. plan() is a template
+ * over the dimensions of the BasicMazeMap, so fixed-size maps get their cell
+ * arithmetic folded.
+ */
+class TimeOptimalPlanner {
+public:
+  explicit TimeOptimalPlanner(const RunCostModel &model = RunCostModel{});
+
+  /**
+   * @brief Find the fastest route to a goal
+   * @param map Walls known so far
+   * @param start Cell and heading of the mouse
+   * @param goals Goal cells
+   * @param target Index of the goal to reach, -1 for any of them
+   * @param policy Whether unobserved walls may be crossed
+   * @return false if no goal can be reached
+   */
+  template <int W, int H>
+  bool plan(const BasicMazeMap<W, H> &map, const Pose &start, const std::vector<Cell> &goals, int target = -1,
+            FloodFillBase::WallPolicy policy = FloodFillBase::WallPolicy::KNOWN_ONLY);
+
+  /// Segments of the last plan()
+  [[nodiscard]] const std::vector<Segment> &get_path() const noexcept { return path_; }
+  /// Estimated time of the last plan(), in seconds
+  [[nodiscard]] double get_time() const noexcept { return time_; }
+
+  /**
+   * @brief Time of a straight of @p cells cells from rest to rest, in seconds
+   */
+  [[nodiscard]] double straight_time(int cells);
+
+  /**
+   * @brief Estimated time of any compiled path under this cost model
+   */
+  [[nodiscard]] double estimate(const std::vector<Segment> &segments);
+
+private:
+  void grow_table(int cells);
+
+  RunCostModel model_;
+  std::vector<double> straight_times_; // index: number of cells
+  std::vector<Segment> path_;
+  double time_{0.0};
+  // per-state scratch: best time and the state it came from
+  std::vector<double> times_;
+  std::vector<int> parents_;
+  std::vector<std::uint8_t> is_goal_;
+  std::vector<std::pair<double, int>> heap_;
+}; // class TimeOptimalPlanner
+
+template <int W, int H>
+bool TimeOptimalPlanner::plan(const BasicMazeMap<W, H> &map, const Pose &start, const std::vector<Cell> &goals, int target,
+                              FloodFillBase::WallPolicy policy) {
+  path_.clear();
+  time_ = 0.0;
+  const int width = map.get_width();
+  const int cells = map.get_cell_count();
+  grow_table(std::max(width, map.get_height()));
+  auto passable = [&map, policy](int x, int y, Direction direction) {
+    return !map.has_wall(x, y, direction) &&
+           (policy == FloodFillBase::WallPolicy::OPTIMISTIC || map.is_known(x, y, direction));
+  };
+
+  is_goal_.assign(static_cast<std::size_t>(cells), 0);
+  for (int g = 0; g < static_cast<int>(goals.size()); ++g) {
+    const Cell &goal = goals[static_cast<std::size_t>(g)];
+    if ((target < 0 || target == g) && map.contains(goal.x, goal.y)) {
+      is_goal_[static_cast<std::size_t>(map.index(goal.x, goal.y))] = 1;
+    }
+  }
+
+  // state = 4 * cell + heading
+  times_.assign(static_cast<std::size_t>(4 * cells), std::numeric_limits<double>::infinity());
+  parents_.assign(static_cast<std::size_t>(4 * cells), -1);
+  heap_.clear();
+  const int origin = 4 * map.index(start.x, start.y) + static_cast<int>(start.heading);
+  times_[static_cast<std::size_t>(origin)] = 0.0;
+  heap_.emplace_back(0.0, origin);
+  auto relax = [this](int from, int to, double time) {
+    if (time < times_[static_cast<std::size_t>(to)]) {
+      times_[static_cast<std::size_t>(to)] = time;
+      parents_[static_cast<std::size_t>(to)] = from;
+      heap_.emplace_back(time, to);
+      std::push_heap(heap_.begin(), heap_.end(), std::greater<>());
+    }
+  };
+
+  int reached = -1;
+  while (!heap_.empty()) {
+    std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+    const auto [time, state] = heap_.back();
+    heap_.pop_back();
+    if (time > times_[static_cast<std::size_t>(state)]) {
+      continue; // stale entry
+    }
+    const int cell = state / 4;
+    const auto heading = static_cast<Direction>(state % 4);
+    if (is_goal_[static_cast<std::size_t>(cell)]) {
+      reached = state;
+      break;
+    }
+    relax(state, 4 * cell + static_cast<int>(turn_left(heading)), time + model_.turn_time);
+    relax(state, 4 * cell + static_cast<int>(turn_right(heading)), time + model_.turn_time);
+    if (state == origin) {
+      // turning around only makes sense before the first move
+      relax(state, 4 * cell + static_cast<int>(opposite(heading)), time + model_.turn_around_time);
+    }
+    int x = cell % width;
+    int y = cell / width;
+    for (int length = 1; passable(x, y, heading); ++length) {
+      x += dx(heading);
+      y += dy(heading);
+      relax(state, 4 * map.index(x, y) + static_cast<int>(heading), time + straight_times_[static_cast<std::size_t>(length)]);
+    }
+  }
+  if (reached < 0) {
+    return false;
+  }
+
+  // walk the parents back to the start, then turn the states into segments
+  time_ = times_[static_cast<std::size_t>(reached)];
+  std::vector<int> states;
+  for (int state = reached; state != -1; state = parents_[static_cast<std::size_t>(state)]) {
+    states.push_back(state);
+  }
+  std::reverse(states.begin(), states.end());
+  for (std::size_t i = 1; i < states.size(); ++i) {
+    const int from = states[i - 1];
+    const int to = states[i];
+    if (from / 4 == to / 4) {
+      path_.push_back(turn_between(static_cast<Direction>(from % 4), static_cast<Direction>(to % 4)));
+    } else {
+      const int distance = std::abs(to / 4 % width - from / 4 % width) + std::abs(to / 4 / width - from / 4 / width);
+      path_.push_back({Segment::Kind::FORWARD, distance});
+    }
+  }
+  return true;
+}
+
+} // namespace micro_mouse
@@ -0,0 +1,242 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+#include "mapped_file.hpp"
+#include "maze_backend.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Commands stored in a trace, one per MazeBackend call
+ */
+enum class TraceOp : std::uint8_t {
+  MAZE_WIDTH,
+  MAZE_HEIGHT,
+  WALL_FRONT,
+  WALL_RIGHT,
+  WALL_LEFT,
+  MOVE_FORWARD,
+  TURN_RIGHT,
+  TURN_LEFT,
+  SET_WALL,
+  CLEAR_WALL,
+  SET_COLOR,
+  CLEAR_COLOR,
+  CLEAR_ALL_COLOR,
+  SET_TEXT,
+  CLEAR_TEXT,
+  CLEAR_ALL_TEXT,
+  WAS_RESET,
+  ACK_RESET,
+  SET_BUFFERED,
+  FLUSH,
+  POST_STEP,
+  WAIT_STEP,
+  FAILURE // the previous command threw, with the message of the exception
+};
+
+/// Name of the mms command, or of the API call, behind an op
+[[nodiscard]] std::string_view trace_op_name(TraceOp op) noexcept;
+
+/**
+ * @brief One command of a trace and its reply
+ *
+ * values holds the integer arguments in call order; for MAZE_WIDTH and
+ * MAZE_HEIGHT the reply, for POST_STEP turns, distance and the sense mask,
+ * for WAIT_STEP the readings as bits: reset, left, front, right. flag holds
+ * the boolean reply of a query, set_buffered_visualization()'s argument or
+ * StepCommand::check_reset. text is the text of SET_TEXT or the message of a
+ * FAILURE, and points into the trace.
+ */
+struct TraceRecord {
+  TraceOp op{TraceOp::FAILURE};
+  bool flag{false};
+  std::int64_t values[3]{};
+  std::string_view text;
+};
+
+/**
+ * @brief Sequential reader of a trace file written by TraceRecorder
+ *
+ * A trace is a header, "RWA4TRC" and a format version, the seed, flags and
+ * step limit given to the recorder, then one record per command. A record is an op
+ * byte, with the flag in its top bit, followed by a payload whose layout is
+ * fixed by the op: zigzag varints for the values, and a varint length and
+ * the bytes for the text. Queries thus take a single byte.
+ *
+ * Records are deliberately not fixed-size, nor prefixed with their payload
+ * length: the op alone tells what follows, and a length field would double
+ * the size of the wall queries that make up most of a trace. Skipping or
+ * indexing records therefore takes a decoding pass, which runs at memory
+ * speed since the file is mapped and decoded in place.
+ */
+class TraceReader {
+public:
+  /**
+   * @brief Map a trace
+   * @throw std::runtime_error if the file cannot be mapped or is no trace
+   */
+  explicit TraceReader(const std::string &path);
+
+  /**
+   * @brief Decode the next record
+   * @return false at the end of the trace
+   * @throw std::runtime_error if the record is truncated or unknown
+   */
+  bool next(TraceRecord &record);
+
+  /// Check whether the next record has the given op
+  [[nodiscard]] bool next_is(TraceOp op) const noexcept;
+  [[nodiscard]] bool at_end() const noexcept { return position_ == file_.size(); }
+  /// Records decoded so far
+  [[nodiscard]] std::uint64_t get_index() const noexcept { return index_; }
+  [[nodiscard]] std::uint64_t get_seed() const noexcept { return seed_; }
+  [[nodiscard]] std::uint64_t get_flags() const noexcept { return flags_; }
+  [[nodiscard]] std::uint64_t get_max_steps() const noexcept { return max_steps_; }
+
+private:
+  [[nodiscard]] std::uint64_t read_varint();
+
+  std::string path_;
+  MappedFile file_;
+  std::size_t position_{0};
+  std::uint64_t index_{0};
+  std::uint64_t seed_{0};
+  std::uint64_t flags_{0};
+  std::uint64_t max_steps_{0};
+}; // class TraceReader
+
+/**
+ * @brief Backend recording every call, and its reply, into a binary trace
+ *
+ * Wraps the backend that does the work, usually the mms text pipe, and
+ * forwards every call to it unchanged, including posted steps. Records are
+ * buffered and written in large blocks; the buffer is flushed when a command
+ * throws, so that the trace of a crashed run ends with the failure, and when
+ * the recorder is destroyed.
+ */
+class TraceRecorder : public MazeBackend {
+public:
+  /**
+   * @brief Start a trace
+   * @param path Output file
+   * @param backend Backend answering the calls, must outlive the recorder
+   * @param seed Seed of the run, for the replay to make the same choices
+   * @param flags Settings of the run, stored as given for the replay
+   * @param max_steps Step limit of the run, stored as given for the replay
+   * @throw std::runtime_error if the file cannot be written
+   */
+  TraceRecorder(const std::string &path, MazeBackend &backend, std::uint64_t seed = 0, std::uint64_t flags = 0,
+                std::uint64_t max_steps = 0);
+  ~TraceRecorder() override;
+
+  TraceRecorder(const TraceRecorder &) = delete;
+  TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+  int get_maze_width() override;
+  int get_maze_height() override;
+  bool has_wall_front() override;
+  bool has_wall_right() override;
+  bool has_wall_left() override;
+  void move_forward(int distance) override;
+  void turn_right() override;
+  void turn_left() override;
+  void set_wall(int x, int y, char direction) override;
+  void clear_wall(int x, int y, char direction) override;
+  void set_color(int x, int y, char color) override;
+  void clear_color(int x, int y) override;
+  void clear_all_color() override;
+  void set_text(int x, int y, const std::string &text) override;
+  void clear_text(int x, int y) override;
+  void clear_all_text() override;
+  bool was_reset() override;
+  void ack_reset() override;
+  void set_buffered_visualization(bool buffered) override;
+  void flush() override;
+  void post_step(const StepCommand &step) override;
+  StepReply wait_step() override;
+
+  /// Records written so far
+  [[nodiscard]] std::uint64_t get_records() const noexcept { return records_; }
+
+private:
+  // Append a record; values are written as zigzag varints
+  void record(TraceOp op, bool flag = false, std::initializer_list<std::int64_t> values = {},
+              std::string_view text = {});
+  // Run a call of the wrapped backend; if it throws, record the command
+  // and a FAILURE, write the trace out and rethrow
+  template <typename Call>
+  auto forward(Call call, TraceOp op, std::initializer_list<std::int64_t> values = {}, std::string_view text = {});
+  void write_out();
+
+  MazeBackend &backend_;
+  std::ofstream out_;
+  std::string buffer_;
+  std::uint64_t records_{0};
+}; // class TraceRecorder
+
+/**
+ * @brief Backend answering the calls of a solver from a trace
+ *
+ * Every call must be the next command of the trace, with the same
+ * arguments; it then gets the recorded reply, and throws where the recorded
+ * command threw. A solver that diverges from the recorded run, by a single
+ * command, argument or step, makes the call throw. Nothing waits on a
+ * simulator, so the solver runs at memory speed, e.g. to profile its
+ * planning alone.
+ */
+class TraceReplayBackend : public MazeBackend {
+public:
+  /**
+   * @brief Open a trace for replay
+   * @throw std::runtime_error if the file is no trace
+   */
+  explicit TraceReplayBackend(const std::string &path) : reader_{path} {}
+
+  int get_maze_width() override;
+  int get_maze_height() override;
+  bool has_wall_front() override;
+  bool has_wall_right() override;
+  bool has_wall_left() override;
+  void move_forward(int distance) override;
+  void turn_right() override;
+  void turn_left() override;
+  void set_wall(int x, int y, char direction) override;
+  void clear_wall(int x, int y, char direction) override;
+  void set_color(int x, int y, char color) override;
+  void clear_color(int x, int y) override;
+  void clear_all_color() override;
+  void set_text(int x, int y, const std::string &text) override;
+  void clear_text(int x, int y) override;
+  void clear_all_text() override;
+  bool was_reset() override;
+  void ack_reset() override;
+  void set_buffered_visualization(bool buffered) override;
+  void flush() override;
+  void post_step(const StepCommand &step) override;
+  StepReply wait_step() override;
+
+  /// Check whether every recorded command was replayed
+  [[nodiscard]] bool at_end() const noexcept { return reader_.at_end(); }
+  [[nodiscard]] std::uint64_t get_index() const noexcept { return reader_.get_index(); }
+  [[nodiscard]] std::uint64_t get_seed() const noexcept { return reader_.get_seed(); }
+  [[nodiscard]] std::uint64_t get_flags() const noexcept { return reader_.get_flags(); }
+  [[nodiscard]] std::uint64_t get_max_steps() const noexcept { return reader_.get_max_steps(); }
+
+private:
+  // Take the next record, which must be @p op with the given values and text
+  const TraceRecord &expect(TraceOp op, std::initializer_list<std::int64_t> values = {},
+                            std::string_view text = {});
+  // Throw the recorded failure of the command just replayed, if any
+  void replay_failure();
+
+  TraceReader reader_;
+  TraceRecord record_;
+}; // class TraceReplayBackend
+
+} // namespace micro_mouse
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace micro_mouse {
+
+/**
+ * @brief Client-side copy of what has been drawn in the simulator
+ *
+ * Records the cell colors, texts and wall markers already sent, so that
+ * MazeControlAPI can drop calls that would not change the display. Each
+ * update function returns true when the command must still be sent.
+ */
+class VisualizationShadow {
+public:
+  /**
+   * @brief Create an empty shadow
+   * @param width Initial width in cells, grown on demand
+   * @param height Initial height in cells, grown on demand
+   */
+  explicit VisualizationShadow(int width = 16, int height = 16);
+
+  bool set_color(int x, int y, char color);
+  bool clear_color(int x, int y);
+  bool clear_all_color();
+  bool set_text(int x, int y, const std::string &text);
+  bool clear_text(int x, int y);
+  bool clear_all_text();
+  bool set_wall(int x, int y, char direction);
+  bool clear_wall(int x, int y, char direction);
+
+  /**
+   * @brief Forget everything, as if the display had been wiped
+   */
+  void clear();
+
+  [[nodiscard]] std::uint64_t get_forwarded() const noexcept { return forwarded_; }
+  [[nodiscard]] std::uint64_t get_suppressed() const noexcept { return suppressed_; }
+
+private:
+  struct Cell {
+    char color{'\0'}; // '\0' when the cell has no color
+    std::uint8_t walls{0}; // bit per Direction; west and south on the boundary only
+    bool has_text{false};
+    std::string text;
+  };
+
+  // Cell at (x, y), growing the grid if needed; nullptr for negative coordinates
+  Cell *cell(int x, int y);
+  // Cell holding the wall on the given side of (x, y), and its bit in
+  // Cell::walls; nullptr for an unknown direction or negative coordinates
+  Cell *wall_cell(int x, int y, char direction, std::uint8_t &mask);
+  // Count the outcome of one call and pass it through
+  bool count(bool changed) noexcept;
+
+  int width_;
+  int height_;
+  std::vector<Cell> cells_;
+  int colored_{0};
+  int texts_{0};
+  std::uint64_t forwarded_{0};
+  std::uint64_t suppressed_{0};
+}; // class VisualizationShadow
+
+} // namespace micro_mouse
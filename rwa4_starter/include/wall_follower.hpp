@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "maze_types.hpp"
+#include "wall_query_cache.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Wall-following controller that notices when it runs in circles
+ *
+ * Keeps one hand on the wall: at every cell it takes the first open side
+ * among that hand, the front and the other hand, and turns around in dead
+ * ends. When the goal stands on an island, away from every wall connected to
+ * the start, it would follow the same loop forever. Since the choice depends
+ * only on the cell, the heading and the walls, the mouse cycles exactly when
+ * it enters a cell with a heading it already had there. Each (cell, heading)
+ * state owns one bit of a bitset, so the check costs O(1) per move, and
+ * run() stops at the first repeated state. The walls it observed and its
+ * pose are then handed to a map-based planner, see BasicExplorer::resume().
+ *
+ * Wall queries go through a WallQueryCache, so sides seen before cost no
+ * round trip.
+ */
+class WallFollower {
+public:
+  /// Hand kept on the wall
+  enum class Hand { LEFT, RIGHT };
+
+  /// Why run() returned
+  enum class Outcome {
+    GOAL,        // the mouse stands on a goal
+    LOOP,        // the mouse came back to a state it was in
+    OUT_OF_MOVES // max_moves was reached first
+  };
+
+  /**
+   * @brief Create a follower for a maze of the given size, at the start
+   * @param width Width of the maze in cells
+   * @param height Height of the maze in cells
+   * @param hand Hand kept on the wall
+   */
+  WallFollower(int width, int height, Hand hand = Hand::LEFT);
+
+  /**
+   * @brief Select the goal cells, the center cells by default
+   */
+  void set_goals(const std::vector<Cell> &goals) { goals_ = goals; }
+
+  /**
+   * @brief Follow the wall until a goal, a loop or the move limit
+   */
+  Outcome run(std::uint64_t max_moves = std::numeric_limits<std::uint64_t>::max());
+
+  /// Walls observed so far and the pose of the mouse
+  [[nodiscard]] const WallQueryCache &get_walls() const noexcept { return walls_; }
+  [[nodiscard]] std::uint64_t get_moves() const noexcept { return moves_; }
+
+private:
+  [[nodiscard]] bool at_goal() const noexcept;
+
+  WallQueryCache walls_;
+  Hand hand_;
+  std::vector<Cell> goals_;
+  // bit 4 * cell + heading: states visited during the current run()
+  std::vector<std::uint64_t> visited_;
+  std::uint64_t moves_{0};
+}; // class WallFollower
+
+} // namespace micro_mouse
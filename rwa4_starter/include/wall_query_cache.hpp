@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+
+#include "maze_map.hpp"
+#include "maze_types.hpp"
+
+namespace micro_mouse {
+
+/**
+ * @brief Wall queries answered from the walls already observed
+ *
+ * Stands in for the motion and wall calls of MazeControlAPI: it forwards
+ * every turn and move, tracking the pose, and records every wall the
+ * simulator reports in a MazeMap. A wall query on a side observed before,
+ * from this cell or from the neighbour sharing the wall, or on the outer
+ * boundary, is answered from the map without a round trip.
+ */
+class WallQueryCache {
+public:
+  /**
+   * @brief Queries answered locally and sent to the simulator
+   */
+  struct Stats {
+    std::uint64_t answered{0};
+    std::uint64_t queried{0};
+  };
+
+  /**
+   * @brief Start with no wall known and the mouse at the start
+   * @param width Width of the maze in cells
+   * @param height Height of the maze in cells
+   */
+  WallQueryCache(int width, int height) : map_{width, height} {}
+
+  bool has_wall_front() { return has_wall(pose_.heading); }
+  bool has_wall_right() { return has_wall(micro_mouse::turn_right(pose_.heading)); }
+  bool has_wall_left() { return has_wall(micro_mouse::turn_left(pose_.heading)); }
+
+  /**
+   * @brief Move forward and follow the mouse
+   * @throw std::runtime_error as MazeControlAPI::move_forward() does
+   */
+  void move_forward(int distance = 1);
+  void turn_right();
+  void turn_left();
+
+  /**
+   * @brief Put the mouse somewhere else, e.g. back at the start after a reset
+   */
+  void set_pose(const Pose &pose) noexcept { pose_ = pose; }
+
+  [[nodiscard]] const MazeMap &get_map() const noexcept { return map_; }
+  [[nodiscard]] const Pose &get_pose() const noexcept { return pose_; }
+  [[nodiscard]] const Stats &get_stats() const noexcept { return stats_; }
+
+private:
+  // Answer for the front, right or left side of the current cell
+  bool has_wall(Direction side);
+
+  MazeMap map_;
+  Pose pose_;
+  Stats stats_;
+}; // class WallQueryCache
+
+} // namespace micro_mouse
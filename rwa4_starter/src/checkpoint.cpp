@@ -0,0 +1,131 @@
+#include "checkpoint.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "flood_fill.hpp"
+
+namespace {
+
+constexpr char kMagic[8] = {'R', 'W', 'A', '4', 'C', 'K', 'P', 'T'};
+// earlier versions: 1 walls and nearest-goal distances, 2 walls only, 3
+// walls and maze id
+constexpr std::uint16_t kVersion = 4;
+constexpr auto kMaxGoals = static_cast<std::size_t>(micro_mouse::FloodFillBase::kMaxGoals);
+constexpr std::size_t kHeaderSize = sizeof(kMagic) + 4 * sizeof(std::uint16_t) + sizeof(std::uint64_t);
+
+void put(std::string &out, std::uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+std::uint64_t get(const std::string &in, std::size_t &pos, int bytes) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[pos++])) << (8 * i);
+    }
+    return value;
+}
+
+std::uint32_t fnv1a(const std::string &data, std::size_t size) {
+    std::uint32_t hash = 2166136261U;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619U;
+    }
+    return hash;
+}
+
+} // namespace
+
+bool micro_mouse::save_checkpoint(const std::string &path, const Checkpoint &checkpoint) {
+    const MazeMap &map = checkpoint.map;
+    const std::size_t words = 4 * map.get_words_per_plane();
+    const std::size_t goals = checkpoint.goals.size();
+    const std::size_t distances = goals * static_cast<std::size_t>(map.get_cell_count());
+    if (goals > kMaxGoals || checkpoint.distances.size() != distances) {
+        return false;
+    }
+
+    std::string data(kMagic, sizeof(kMagic));
+    data.reserve(kHeaderSize + 4 * goals + 8 * words + 2 * distances + 4);
+    put(data, kVersion, 2);
+    put(data, static_cast<std::uint64_t>(map.get_width()), 2);
+    put(data, static_cast<std::uint64_t>(map.get_height()), 2);
+    put(data, goals, 2);
+    put(data, checkpoint.maze_id, 8);
+    for (const Cell &goal : checkpoint.goals) {
+        put(data, static_cast<std::uint64_t>(goal.x), 2);
+        put(data, static_cast<std::uint64_t>(goal.y), 2);
+    }
+    const std::uint64_t *planes = map.get_plane(MazeMap::Plane::EAST_KNOWN);
+    for (std::size_t i = 0; i < words; ++i) {
+        put(data, planes[i], 8);
+    }
+    for (const std::uint16_t distance : checkpoint.distances) {
+        put(data, distance, 2);
+    }
+    put(data, fnv1a(data, data.size()), 4);
+
+    const std::string staging = path + ".tmp";
+    {
+        std::ofstream file(staging, std::ios::binary | std::ios::trunc);
+        if (!file.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+            return false;
+        }
+    }
+    return std::rename(staging.c_str(), path.c_str()) == 0;
+}
+
+bool micro_mouse::load_checkpoint(const std::string &path, Checkpoint &checkpoint) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    const std::string data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if (data.size() < kHeaderSize + 4 || data.compare(0, sizeof(kMagic), kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    std::size_t pos = sizeof(kMagic);
+    const auto version = get(data, pos, 2);
+    const auto width = static_cast<int>(get(data, pos, 2));
+    const auto height = static_cast<int>(get(data, pos, 2));
+    const auto goal_count = static_cast<std::size_t>(get(data, pos, 2));
+    const std::uint64_t maze_id = get(data, pos, 8);
+    if (version != kVersion || width <= 0 || height <= 0 || goal_count > kMaxGoals) {
+        return false;
+    }
+    MazeMap map(width, height);
+    const std::size_t words = 4 * map.get_words_per_plane();
+    const std::size_t count = goal_count * static_cast<std::size_t>(map.get_cell_count());
+    if (data.size() != kHeaderSize + 4 * goal_count + 8 * words + 2 * count + 4) {
+        return false;
+    }
+    std::size_t end = data.size() - 4;
+    if (get(data, end, 4) != fnv1a(data, data.size() - 4)) {
+        return false;
+    }
+
+    std::vector<Cell> goals(goal_count);
+    for (auto &goal : goals) {
+        goal.x = static_cast<int>(get(data, pos, 2));
+        goal.y = static_cast<int>(get(data, pos, 2));
+    }
+    std::vector<std::uint64_t> planes(words);
+    for (auto &word : planes) {
+        word = get(data, pos, 8);
+    }
+    std::vector<std::uint16_t> distances(count);
+    for (auto &distance : distances) {
+        distance = static_cast<std::uint16_t>(get(data, pos, 2));
+    }
+    map.set_words(planes);
+    checkpoint.maze_id = maze_id;
+    checkpoint.map = std::move(map);
+    checkpoint.goals = std::move(goals);
+    checkpoint.distances = std::move(distances);
+    return true;
+}
@@ -0,0 +1,4 @@
+#include "dead_end_pruner.hpp"
+
+template class micro_mouse::BasicDeadEndPruner<micro_mouse::kClassicSize, micro_mouse::kClassicSize>;
+template class micro_mouse::BasicDeadEndPruner<micro_mouse::kDynamic, micro_mouse::kDynamic>;
@@ -0,0 +1,9 @@
+#include "direct_backend.hpp"
+
+#include <stdexcept>
+
+void micro_mouse::DirectBackend::move_forward(int distance) {
+    if (!maze_.move_forward(distance)) {
+        throw std::runtime_error("crash");
+    }
+}
@@ -0,0 +1,499 @@
+#include "explorer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "maze_api.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::uint64_t nanoseconds_since(Clock::time_point start) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+// Run a step as separate blocking commands; nothing is read after a reset
+micro_mouse::StepReply send_step(const micro_mouse::StepCommand &step) {
+    using micro_mouse::MazeControlAPI;
+    switch (step.turns & 3) {
+    case 1:
+        MazeControlAPI::turn_right();
+        break;
+    case 2:
+        MazeControlAPI::turn_right();
+        MazeControlAPI::turn_right();
+        break;
+    case 3:
+        MazeControlAPI::turn_left();
+        break;
+    default:
+        break;
+    }
+    if (step.distance != 0) {
+        MazeControlAPI::move_forward(step.distance);
+    }
+    micro_mouse::StepReply reply;
+    reply.reset = step.check_reset && MazeControlAPI::was_reset();
+    if (reply.reset) {
+        return reply;
+    }
+    reply.wall_left = (step.sense & 1U) && MazeControlAPI::has_wall_left();
+    reply.wall_front = (step.sense & 2U) && MazeControlAPI::has_wall_front();
+    reply.wall_right = (step.sense & 4U) && MazeControlAPI::has_wall_right();
+    return reply;
+}
+
+} // namespace
+
+template <int W, int H>
+micro_mouse::BasicExplorer<W, H>::BasicExplorer(int width, int height)
+    : map_{width, height},
+      observed_{width, height},
+      pruner_{width, height},
+      guess_{width, height},
+      goals_{{(width - 1) / 2, (height - 1) / 2}, {(width - 1) / 2, height / 2},
+             {width / 2, (height - 1) / 2}, {width / 2, height / 2}} {}
+
+template <int W, int H>
+bool micro_mouse::BasicExplorer<W, H>::is_target(int x, int y) const noexcept {
+    for (int g = 0; g < static_cast<int>(goals_.size()); ++g) {
+        const Cell &goal = goals_[static_cast<std::size_t>(g)];
+        if ((target_ < 0 || target_ == g) && x == goal.x && y == goal.y) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <int W, int H>
+bool micro_mouse::BasicExplorer<W, H>::at_goal() const noexcept {
+    return is_target(pose_.x, pose_.y);
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::set_visualize(bool enabled) noexcept {
+    visualize_ = enabled;
+    map_.set_visualize(enabled);
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::sense() {
+    // which sides to read is settled before the first reading, as for a step
+    const unsigned unknown = unknown_sides(pose_);
+    if (unknown & 1U) {
+        observe(pose_.x, pose_.y, turn_left(pose_.heading), MazeControlAPI::has_wall_left());
+    }
+    if (unknown & 2U) {
+        observe(pose_.x, pose_.y, pose_.heading, MazeControlAPI::has_wall_front());
+    }
+    if (unknown & 4U) {
+        observe(pose_.x, pose_.y, turn_right(pose_.heading), MazeControlAPI::has_wall_right());
+    }
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::observe(int x, int y, Direction direction, bool present) {
+    // a wall closing one of its shortest paths disproves a restored field
+    if (seeded_ && present && on_shortest_path(planner_, x, y, direction)) {
+        seeded_ = false;
+    }
+    map_.set_wall(x, y, direction, present);
+    observed_.set_wall(x, y, direction, present);
+    ++stats_.wall_queries;
+    if (pruning_ && present) {
+        pruner_.wall_added(map_, x, y, direction);
+    }
+}
+
+template <int W, int H>
+bool micro_mouse::BasicExplorer<W, H>::confirm() {
+    const Direction sides[] = {turn_left(pose_.heading), pose_.heading, turn_right(pose_.heading)};
+    const bool present[] = {MazeControlAPI::has_wall_left(), MazeControlAPI::has_wall_front(),
+                            MazeControlAPI::has_wall_right()};
+    for (int i = 0; i < 3; ++i) {
+        if (!map_.is_known(pose_.x, pose_.y, sides[i])) {
+            observe(pose_.x, pose_.y, sides[i], present[i]);
+            continue;
+        }
+        ++stats_.wall_queries;
+        if (map_.has_wall(pose_.x, pose_.y, sides[i]) != present[i]) {
+            return false;
+        }
+        observed_.set_wall(pose_.x, pose_.y, sides[i], present[i]);
+    }
+    return true;
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::forget() {
+    if (visualize_) {
+        for (int y = 0; y < map_.get_height(); ++y) {
+            for (int x = 0; x < map_.get_width(); ++x) {
+                for (const Direction side : {Direction::EAST, Direction::NORTH}) {
+                    if (map_.has_wall(x, y, side) && !observed_.has_wall(x, y, side)) {
+                        MazeControlAPI::clear_wall(x, y, to_char(side));
+                    }
+                }
+            }
+        }
+    }
+    map_ = observed_;
+    map_.set_visualize(visualize_);
+    seeded_ = false;
+}
+
+template <int W, int H>
+bool micro_mouse::BasicExplorer<W, H>::leads_to_blocked(int x, int y, Direction side) const noexcept {
+    // unknown walls are never on the border, so the neighbour exists
+    return pruning_ && pruner_.is_blocked(x + dx(side), y + dy(side));
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::face(Direction direction) {
+    switch ((static_cast<int>(direction) - static_cast<int>(pose_.heading)) & 3) {
+    case 1:
+        MazeControlAPI::turn_right();
+        ++stats_.turns;
+        break;
+    case 2:
+        MazeControlAPI::turn_right();
+        MazeControlAPI::turn_right();
+        stats_.turns += 2;
+        break;
+    case 3:
+        MazeControlAPI::turn_left();
+        ++stats_.turns;
+        break;
+    default:
+        break;
+    }
+    pose_.heading = direction;
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::advance(int cells) {
+    MazeControlAPI::move_forward(cells);
+    pose_.x += cells * dx(pose_.heading);
+    pose_.y += cells * dy(pose_.heading);
+    ++stats_.moves;
+    if (pruning_) {
+        pruner_.move_mouse(map_, pose_.x, pose_.y);
+    }
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::draw_distances() const {
+    for (int y = 0; y < map_.get_height(); ++y) {
+        for (int x = 0; x < map_.get_width(); ++x) {
+            const std::uint16_t distance =
+                target_ < 0 ? planner_.get_distance(x, y) : planner_.get_goal_distance(target_, x, y);
+            MazeControlAPI::set_text(x, y, distance == Planner::kUnreachable ? "-" : std::to_string(distance));
+        }
+    }
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::plan(Planner &planner, const Map &map) {
+    const auto start = Clock::now();
+    planner.compute(map, goals_, pruning_ ? pruner_.get_blocked() : nullptr);
+    stats_.plan_ns += nanoseconds_since(start);
+    ++stats_.plans;
+}
+
+template <int W, int H>
+bool micro_mouse::BasicExplorer<W, H>::explore(std::uint64_t max_moves) {
+    begin(max_moves);
+    while (exploring_ && !pipelined_) {
+        answer(send_step(command_));
+    }
+    while (exploring_) {
+        MazeControlAPI::post_step(command_);
+        speculate();
+        const auto waiting = Clock::now();
+        const StepReply reply = MazeControlAPI::wait_step();
+        // speculate more while replies keep the explorer idle for longer than
+        // a plan after the whole budget is spent, less when they are already
+        // there; the first step has no field to speculate from
+        if (command_.distance != 0) {
+            const std::uint64_t idle_ns = nanoseconds_since(waiting);
+            // a restored field may have spared every plan so far
+            const std::uint64_t plan_ns = stats_.plans == 0 ? 0 : stats_.plan_ns / stats_.plans;
+            const bool spent = __builtin_popcount(speculated_) == speculation_budget_;
+            if (spent && idle_ns > plan_ns) {
+                speculation_budget_ = std::min(speculation_budget_ + 1, kMaxSpeculations);
+            } else if (idle_ns <= plan_ns && speculation_budget_ > 0) {
+                --speculation_budget_;
+            }
+        }
+        answer(reply);
+    }
+    return at_goal();
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::begin(std::uint64_t max_moves) {
+    if (pruning_) {
+        // the goals, map or pose may have changed since the last call
+        std::vector<Cell> terminals{goals_};
+        terminals.push_back({0, 0});
+        pruner_.rebuild(map_, terminals, {pose_.x, pose_.y});
+    }
+    max_moves_ = max_moves;
+    moves_made_ = 0;
+    speculated_ = 0;
+    exploring_ = !at_goal() && max_moves > 0;
+    // read the cell of the mouse in place, then move from there
+    command_ = StepCommand{};
+    command_.distance = 0;
+    command_.check_reset = watch_reset_;
+    command_.sense = unknown_sides(pose_);
+}
+
+template <int W, int H>
+unsigned micro_mouse::BasicExplorer<W, H>::unknown_sides(const Pose &pose) const noexcept {
+    // walls observed before, from this cell or from the neighbour across
+    // them, are not asked again, nor walls in front of pruned cells
+    const Direction sides[] = {turn_left(pose.heading), pose.heading, turn_right(pose.heading)};
+    unsigned unknown = 0;
+    for (int i = 0; i < 3; ++i) {
+        if (!map_.is_known(pose.x, pose.y, sides[i]) && !leads_to_blocked(pose.x, pose.y, sides[i])) {
+            unknown |= 1U << i;
+        }
+    }
+    return unknown;
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::answer(const StepReply &reply) {
+    if (!exploring_) {
+        throw std::logic_error("no exploration in progress");
+    }
+    // the step turned, moved, then read the walls around the new pose
+    const int turns = command_.turns & 3;
+    stats_.turns += turns == 3 ? 1 : static_cast<std::uint64_t>(turns);
+    pose_.heading = static_cast<Direction>((static_cast<int>(pose_.heading) + turns) & 3);
+    const bool first = command_.distance == 0;
+    if (!first) {
+        pose_.x += command_.distance * dx(pose_.heading);
+        pose_.y += command_.distance * dy(pose_.heading);
+        ++stats_.moves;
+        ++moves_made_;
+        if (pruning_) {
+            pruner_.move_mouse(map_, pose_.x, pose_.y);
+        }
+    }
+    // nothing was read after the last move
+    if (at_goal() || moves_made_ == max_moves_ || reply.reset) {
+        exploring_ = false;
+        return;
+    }
+
+    const Direction sides[] = {turn_left(pose_.heading), pose_.heading, turn_right(pose_.heading)};
+    const bool present[] = {reply.wall_left, reply.wall_front, reply.wall_right};
+    unsigned closed = 0;
+    bool field_holds = !first;
+    for (int i = 0; i < 3; ++i) {
+        if (((command_.sense >> i) & 1U) == 0) {
+            continue;
+        }
+        if (present[i]) {
+            closed |= 1U << i;
+            field_holds = field_holds && !on_shortest_path(planner_, pose_.x, pose_.y, sides[i]);
+        }
+        observe(pose_.x, pose_.y, sides[i], present[i]);
+    }
+    // in pipelined mode, the field planned before the move may still hold,
+    // or one computed while the step was in flight may match the readings
+    const bool hit = closed != 0 && ((speculated_ >> closed) & 1U);
+    stats_.discarded += static_cast<std::uint64_t>(__builtin_popcount(speculated_)) - (hit ? 1 : 0);
+    speculated_ = 0;
+    // in either mode, a field restored from a checkpoint stands in for the
+    // first plan unless the readings disproved it, see observe()
+    const bool restored = first && seeded_;
+    seeded_ = false;
+    if (!restored && (!pipelined_ || !(field_holds || hit))) {
+        plan(planner_, map_);
+    } else if (!restored && !field_holds) {
+        std::swap(planner_, speculative_[closed]);
+    }
+    if (visualize_) {
+        draw_distances();
+    }
+
+    Direction direction = pose_.heading;
+    if (!planner_.next_direction(map_, pose_, direction, target_)) {
+        // the goal is walled off
+        exploring_ = false;
+        return;
+    }
+    const Pose next{pose_.x + dx(direction), pose_.y + dy(direction), direction};
+    // query nothing after the last move
+    const bool last = is_target(next.x, next.y) || moves_made_ + 1 == max_moves_;
+    command_ = StepCommand{};
+    command_.turns = (static_cast<int>(direction) - static_cast<int>(pose_.heading)) & 3;
+    command_.check_reset = watch_reset_ && !last;
+    command_.sense = last ? 0U : unknown_sides(next);
+}
+
+template <int W, int H>
+bool micro_mouse::BasicExplorer<W, H>::on_shortest_path(const Planner &field, int x, int y,
+                                                        Direction side) const noexcept {
+    // a passage between two cells at the same distance from every goal is on
+    // no shortest path, so closing it leaves the whole field unchanged
+    for (int g = 0; g < static_cast<int>(goals_.size()); ++g) {
+        if (field.get_goal_distance(g, x, y) != field.get_goal_distance(g, x + dx(side), y + dy(side))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::speculate() {
+    // Hypotheses about the unknown sides of the next cell, as masks of the
+    // sides found closed. The current field counts them as open, so it
+    // already holds for mask 0; while the step is in flight, compute the
+    // fields of as many other masks as the round trip leaves time for,
+    // fewest walls first. The first step has no field yet.
+    if (command_.distance == 0) {
+        return;
+    }
+    const auto heading = static_cast<Direction>((static_cast<int>(pose_.heading) + command_.turns) & 3);
+    const Pose next{pose_.x + command_.distance * dx(heading), pose_.y + command_.distance * dy(heading), heading};
+    const Direction sides[] = {turn_left(heading), heading, turn_right(heading)};
+    int budget = speculation_budget_;
+    for (const unsigned mask : {1U, 2U, 4U, 3U, 5U, 6U, 7U}) {
+        if (budget == 0) {
+            break;
+        }
+        if ((mask & ~command_.sense) != 0) {
+            continue;
+        }
+        guess_ = map_;
+        guess_.set_visualize(false);
+        for (int i = 0; i < 3; ++i) {
+            if ((mask >> i) & 1U) {
+                guess_.set_wall(next.x, next.y, sides[i]);
+            }
+        }
+        plan(speculative_[mask], guess_);
+        ++stats_.speculations;
+        speculated_ |= 1U << mask;
+        --budget;
+    }
+}
+
+template <int W, int H>
+bool micro_mouse::BasicExplorer<W, H>::restore(const Checkpoint &checkpoint, bool trusted) {
+    const MazeMap &map = checkpoint.map;
+    if (map.get_width() != map_.get_width() || map.get_height() != map_.get_height()) {
+        return false;
+    }
+    sense();
+    Map adopted(map);
+    bool added = false;
+    for (int y = 0; y < map_.get_height(); ++y) {
+        for (int x = 0; x < map_.get_width(); ++x) {
+            for (const Direction side : {Direction::EAST, Direction::NORTH}) {
+                if (!observed_.is_known(x, y, side)) {
+                    continue;
+                }
+                const bool present = observed_.has_wall(x, y, side);
+                if (adopted.is_known(x, y, side) && adopted.has_wall(x, y, side) != present) {
+                    return false;
+                }
+                added = adopted.set_wall(x, y, side, present) || added;
+            }
+        }
+    }
+    if (trusted) {
+        observed_ = adopted;
+    }
+    map_ = std::move(adopted);
+    map_.set_visualize(visualize_);
+    // the field was computed on the map as saved, towards the goals saved
+    const auto same_cell = [](const Cell &a, const Cell &b) { return a.x == b.x && a.y == b.y; };
+    seeded_ = !added &&
+              std::equal(goals_.begin(), goals_.end(), checkpoint.goals.begin(), checkpoint.goals.end(), same_cell) &&
+              checkpoint.distances.size() == goals_.size() * static_cast<std::size_t>(map_.get_cell_count());
+    if (seeded_) {
+        planner_.assign(map_, static_cast<int>(goals_.size()), checkpoint.distances.data());
+    }
+    if (visualize_) {
+        map_.draw();
+    }
+    return true;
+}
+
+template <int W, int H>
+void micro_mouse::BasicExplorer<W, H>::resume(const MazeMap &map, const Pose &pose) {
+    if (map.get_width() != map_.get_width() || map.get_height() != map_.get_height()) {
+        throw std::invalid_argument("map does not fit the maze");
+    }
+    map_ = Map(map);
+    observed_ = map_;
+    seeded_ = false;
+    map_.set_visualize(visualize_);
+    if (visualize_) {
+        map_.draw();
+    }
+    pose_ = pose;
+}
+
+template <int W, int H>
+bool micro_mouse::BasicExplorer<W, H>::speed_run() {
+    ++stats_.plans;
+    const auto start = Clock::now();
+    const bool found = runner_.plan(map_, pose_, goals_, target_);
+    stats_.plan_ns += nanoseconds_since(start);
+    if (!found) {
+        return at_goal();
+    }
+    if (!execute(runner_.get_path())) {
+        ++stats_.conflicts;
+        forget();
+        return false;
+    }
+    return at_goal();
+}
+
+template <int W, int H>
+bool micro_mouse::BasicExplorer<W, H>::execute(const std::vector<Segment> &segments) {
+    for (const auto &segment : segments) {
+        switch (segment.kind) {
+        case Segment::Kind::FORWARD:
+            // read the passage ahead unless this maze showed it already, then
+            // take all the passages it showed in one move
+            for (int remaining = segment.cells; remaining > 0;) {
+                if (!observed_.is_known(pose_.x, pose_.y, pose_.heading) && !confirm()) {
+                    return false;
+                }
+                int cells = 1;
+                while (cells < remaining && observed_.is_known(pose_.x + cells * dx(pose_.heading),
+                                                               pose_.y + cells * dy(pose_.heading), pose_.heading)) {
+                    ++cells;
+                }
+                advance(cells);
+                remaining -= cells;
+            }
+            break;
+        case Segment::Kind::TURN_LEFT:
+            face(turn_left(pose_.heading));
+            break;
+        case Segment::Kind::TURN_RIGHT:
+            face(turn_right(pose_.heading));
+            break;
+        case Segment::Kind::TURN_AROUND:
+            face(opposite(pose_.heading));
+            break;
+        }
+    }
+    return true;
+}
+
+template class micro_mouse::BasicExplorer<micro_mouse::kClassicSize, micro_mouse::kClassicSize>;
+template class micro_mouse::BasicExplorer<micro_mouse::kDynamic, micro_mouse::kDynamic>;
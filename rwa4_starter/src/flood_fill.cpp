@@ -0,0 +1,4 @@
+#include "flood_fill.hpp"
+
+template class micro_mouse::BasicFloodFillPlanner<micro_mouse::kClassicSize, micro_mouse::kClassicSize>;
+template class micro_mouse::BasicFloodFillPlanner<micro_mouse::kDynamic, micro_mouse::kDynamic>;
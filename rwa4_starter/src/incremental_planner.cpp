@@ -0,0 +1,4 @@
+#include "incremental_planner.hpp"
+
+template class micro_mouse::BasicIncrementalPlanner<micro_mouse::kClassicSize, micro_mouse::kClassicSize>;
+template class micro_mouse::BasicIncrementalPlanner<micro_mouse::kDynamic, micro_mouse::kDynamic>;
@@ -1,7 +1,23 @@
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
 #include <iostream>
+#include <memory>
+#include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "checkpoint.hpp"
+#include "direct_backend.hpp"
+#include "explorer.hpp"
 #include "maze_api.hpp"
+#include "maze_simulator.hpp"
+#include "trace.hpp"
+#include "visualization_shadow.hpp"
+#include "wall_follower.hpp"
 
 void log(const std::string& text) {
   std::cerr << text << std::endl;
@@ -9,26 +25,320 @@ void log(const std::string& text) {
 
 using MMS = micro_mouse::MazeControlAPI;
 
-int main() {
-  log("Running...");
-  MMS::set_color(0, 0, 'G');
-  MMS::set_text(0, 0, "S");
-  
-  MMS::set_text(7, 7, "(7,7)");
-  MMS::set_text(7, 8, "(7,8)");
-  MMS::set_text(8, 7, "(8,7)");
-  MMS::set_text(8, 8, "(8,8)");
-  MMS::set_color(7, 7, 'y');
-  MMS::set_color(7, 8, 'y');
-  MMS::set_color(8, 7, 'y');
-  MMS::set_color(8, 8, 'y');
-  while (true) {
-    if (!MMS::has_wall_left()) {
-      MMS::turn_left();
-    }
-    while (MMS::has_wall_front()) {
-      MMS::turn_right();
-    }
-    MMS::move_forward();
-  }
-}
\ No newline at end of file
+// Pause between two wasReset queries while waiting for the user to reset
+constexpr std::chrono::milliseconds kResetPollInterval{50};
+
+// Settings of a run; a trace keeps the ones marked with a flag, and the step
+// limit
+struct Options {
+  bool simulated{false};  // in-process maze, flag 1
+  bool follow{false};     // wall follower first, flag 2
+  std::uint64_t max_steps{1000000};
+  std::string checkpoint; // flag 4 when set; the file itself is not kept
+  std::uint64_t maze_id{0}; // fingerprint of the --maze file, 0 under mms
+  std::uint32_t seed{0};  // picks the target goal
+  bool profile{false};    // report the planning time and overlay traffic at the end
+};
+
+// Explores and runs the maze, repeating runs across resets when a
+// checkpoint is kept; returns the exit status
+template <typename ExplorerType>
+int run(int width, int height, const Options& options) {
+  const bool simulated = options.simulated;
+  const std::uint64_t max_steps = options.max_steps;
+  const std::string& checkpoint = options.checkpoint;
+  // only the simulator can reset the mouse, the direct backend never does
+  const bool resets = !checkpoint.empty() && !simulated;
+
+  // one of the four center cells, chosen at random; the planner tracks all
+  // four in the same pass. A reset ends the run in any center cell, so when
+  // runs are repeated any of them will do
+  ExplorerType explorer(width, height);
+  int target = -1;
+  if (resets) {
+    log("Goal: any center cell");
+  } else {
+    std::mt19937 rng{options.seed};
+    target = static_cast<int>(rng() % explorer.get_goals().size());
+    explorer.set_goals(explorer.get_goals(), target);
+    const micro_mouse::Cell goal = explorer.get_goals()[static_cast<std::size_t>(target)];
+    log("Goal: (" + std::to_string(goal.x) + "," + std::to_string(goal.y) + ")");
+  }
+
+  auto report_planner = [&]() {
+    log("Planner: " + std::to_string(explorer.get_stats().plans) + " plans in " +
+        std::to_string(static_cast<double>(explorer.get_stats().plan_ns) / 1e6) + " ms");
+    // overlay calls the shadow found to change nothing on screen
+    if (const micro_mouse::VisualizationShadow* shadow = MMS::get_shadow()) {
+      log("Visualization: " + std::to_string(shadow->get_forwarded()) + " commands sent, " +
+          std::to_string(shadow->get_suppressed()) + " suppressed");
+    }
+  };
+
+  explorer.set_visualize(!simulated);
+  // plan while the simulator answers; the direct backend answers at once
+  explorer.set_pipelined(!simulated);
+  auto save = [&]() {
+    // with the distances to every goal, a warm start that still has to
+    // explore skips its first plan
+    micro_mouse::Checkpoint state{options.maze_id, micro_mouse::MazeMap{explorer.get_map()}, explorer.get_goals(), {}};
+    micro_mouse::FloodFillPlanner field;
+    field.compute(state.map, state.goals);
+    for (int cell = 0; cell < state.map.get_cell_count(); ++cell) {
+      for (int goal = 0; goal < field.get_goal_count(); ++goal) {
+        state.distances.push_back(field.get_goal_distance(goal, cell % width, cell / width));
+      }
+    }
+    if (!micro_mouse::save_checkpoint(checkpoint, state)) {
+      log("Cannot write checkpoint " + checkpoint);
+    }
+  };
+  // a map learned in another maze of the same size would pass the start
+  // cell check and run the mouse into walls
+  micro_mouse::Checkpoint saved;
+  auto restore = [&]() {
+    if (!micro_mouse::load_checkpoint(checkpoint, saved)) {
+      return false;
+    }
+    if (saved.maze_id != options.maze_id) {
+      log("Checkpoint " + checkpoint + " was learned in another maze");
+      return false;
+    }
+    // the fingerprint vouches for every wall, the mms simulator for none
+    return explorer.restore(saved, options.maze_id != 0);
+  };
+  bool warm = !checkpoint.empty() && restore();
+  if (warm) {
+    log("Checkpoint restored, skipping exploration");
+  }
+  if (options.follow && !warm) {
+    // follow the left wall first; the explorer takes over at the goal, or
+    // as soon as the follower runs in circles
+    micro_mouse::WallFollower follower(width, height);
+    if (target >= 0) {
+      follower.set_goals({explorer.get_goals()[static_cast<std::size_t>(target)]});
+    }
+    const auto outcome = follower.run(max_steps);
+    const std::string moves = std::to_string(follower.get_moves()) + " moves";
+    if (outcome == micro_mouse::WallFollower::Outcome::GOAL) {
+      log("Wall follower: goal reached after " + moves);
+    } else if (outcome == micro_mouse::WallFollower::Outcome::LOOP) {
+      log("Wall follower: loop after " + moves + ", switching to flood fill");
+    } else {
+      log("Wall follower: out of moves after " + moves);
+    }
+    explorer.resume(follower.get_walls().get_map(), follower.get_walls().get_pose());
+  }
+  explorer.set_watch_reset(resets);
+  for (;;) {
+    if (warm) {
+      // speed run over known cells
+      const auto moves_before = explorer.get_stats().moves;
+      const auto conflicts_before = explorer.get_stats().conflicts;
+      if (explorer.speed_run()) {
+        log("Speed run: " + std::to_string(explorer.get_stats().moves - moves_before) + " moves, about " +
+            std::to_string(explorer.get_runner().get_time()) + " s");
+      } else if (explorer.get_stats().conflicts != conflicts_before) {
+        // the map was dropped; explore from where the mouse stopped
+        log("Speed run stopped: a wall differs from the checkpoint, exploring again");
+        warm = false;
+      } else {
+        // the checkpoint's distance field spares the first plan
+        log("No explored route to the goal, exploring");
+        warm = false;
+      }
+    }
+    if (!warm) {
+      if (explorer.explore(max_steps)) {
+        log("Goal reached");
+        MMS::set_color(explorer.get_pose().x, explorer.get_pose().y, 'G');
+        // back to the start, still exploring, unless the mouse is put back
+        if (!resets || !MMS::was_reset()) {
+          const std::vector<micro_mouse::Cell> goals = explorer.get_goals();
+          explorer.set_goals({{0, 0}});
+          warm = explorer.explore(max_steps);
+          explorer.set_goals(goals, target);
+        }
+      } else if (!resets || !MMS::was_reset()) {
+        log("Goal not reached");
+        MMS::flush();
+        if (options.profile) {
+          report_planner();
+        }
+        return 1;
+      }
+      if (!checkpoint.empty()) {
+        save();
+      }
+      if (warm) {
+        continue;
+      }
+    }
+    if (!resets) {
+      break;
+    }
+    // the next run starts from the checkpoint once the mouse is put back;
+    // a person presses reset, so a few polls a second are enough
+    while (!MMS::was_reset()) {
+      std::this_thread::sleep_for(kResetPollInterval);
+    }
+    MMS::ack_reset();
+    explorer.restart();
+    if (restore()) {
+      log("Reset, checkpoint reloaded");
+    }
+    warm = true;
+  }
+  if (options.profile) {
+    report_planner();
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  // "rwa4_cpp --maze <file> [max-steps]" runs against an in-process
+  // simulator instead of the mms GUI; "--checkpoint <file>" keeps what was
+  // learned across resets and runs; "--follow" starts with a wall follower;
+  // "--profile" reports the planning time and the overlay traffic saved by
+  // the visualization shadow; "--record <file>" writes a trace of the run, which "--replay <file>"
+  // feeds back to the solver to check that it sends the same commands
+  Options options;
+  std::string maze_path;
+  std::string record;
+  std::string replay_path;
+  bool usage = false;
+  for (int arg = 1; arg < argc && !usage; ++arg) {
+    const std::string option = argv[arg];
+    const bool has_value = arg + 1 < argc;
+    if (option == "--maze" && has_value) {
+      maze_path = argv[++arg];
+    } else if (option == "--checkpoint" && has_value) {
+      options.checkpoint = argv[++arg];
+    } else if (option == "--follow") {
+      options.follow = true;
+    } else if (option == "--profile") {
+      options.profile = true;
+    } else if (option == "--record" && has_value) {
+      record = argv[++arg];
+    } else if (option == "--replay" && has_value) {
+      replay_path = argv[++arg];
+    } else {
+      // anything else must be the step limit, digits only
+      const char* const end = option.data() + option.size();
+      const auto [last, error] = std::from_chars(option.data(), end, options.max_steps);
+      usage = option.empty() || error != std::errc{} || last != end;
+    }
+  }
+  if (usage) {
+    std::cerr << "usage: rwa4_cpp [--maze FILE] [--checkpoint FILE] [--follow] [--profile] [--record FILE]"
+                 " [--replay FILE] [max-steps]"
+              << std::endl;
+    return 1;
+  }
+
+  std::unique_ptr<micro_mouse::MazeSimulator> maze;
+  std::unique_ptr<micro_mouse::DirectBackend> direct;
+  std::unique_ptr<micro_mouse::TraceReplayBackend> replay;
+  std::unique_ptr<micro_mouse::TraceRecorder> recorder;
+  try {
+    if (!maze_path.empty()) {
+      maze = std::make_unique<micro_mouse::MazeSimulator>(micro_mouse::MazeSimulator::from_file(maze_path));
+      direct = std::make_unique<micro_mouse::DirectBackend>(*maze);
+      options.maze_id = maze->get_fingerprint();
+      MMS::set_backend(direct.get());
+    }
+    // a replay restores the settings and the seed of the recorded run
+    options.simulated = maze != nullptr;
+    options.seed = std::random_device{}();
+    if (!replay_path.empty()) {
+      replay = std::make_unique<micro_mouse::TraceReplayBackend>(replay_path);
+      options.simulated = (replay->get_flags() & 1U) != 0;
+      options.follow = (replay->get_flags() & 2U) != 0;
+      options.seed = static_cast<std::uint32_t>(replay->get_seed());
+      options.max_steps = replay->get_max_steps();
+      options.profile = true;
+      // the run read and wrote its checkpoint outside the trace: replay it
+      // only against a checkpoint given again, and the other way round
+      if (((replay->get_flags() & 4U) != 0) != !options.checkpoint.empty()) {
+        log((options.checkpoint.empty() ? "The recorded run used a checkpoint, pass --checkpoint"
+                                        : "The recorded run used no checkpoint, drop --checkpoint") +
+            std::string(" to replay it"));
+        return 1;
+      }
+      MMS::set_backend(replay.get());
+    }
+    if (!record.empty()) {
+      recorder = std::make_unique<micro_mouse::TraceRecorder>(
+          record, MMS::get_backend(), options.seed,
+          (options.simulated ? 1U : 0U) | (options.follow ? 2U : 0U) | (options.checkpoint.empty() ? 0U : 4U),
+          options.max_steps);
+      MMS::set_backend(recorder.get());
+    }
+  } catch (const std::exception& e) {
+    log(e.what());
+    return 1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  int status = 0;
+  try {
+    log("Running...");
+    // overlay commands go out together with the next query instead of one
+    // flush each
+    MMS::set_buffered_visualization(true);
+    MMS::set_shadow_enabled(true);
+    MMS::set_color(0, 0, 'G');
+    MMS::set_text(0, 0, "S");
+
+    MMS::set_text(7, 7, "(7,7)");
+    MMS::set_text(7, 8, "(7,8)");
+    MMS::set_text(8, 7, "(8,7)");
+    MMS::set_text(8, 8, "(8,8)");
+    MMS::set_color(7, 7, 'y');
+    MMS::set_color(7, 8, 'y');
+    MMS::set_color(8, 7, 'y');
+    MMS::set_color(8, 8, 'y');
+
+    // 16x16 mazes get the explorer specialized for them
+    const int width = MMS::get_maze_width();
+    const int height = MMS::get_maze_height();
+    status = width == micro_mouse::kClassicSize && height == micro_mouse::kClassicSize
+                 ? run<micro_mouse::ClassicExplorer>(width, height, options)
+                 : run<micro_mouse::Explorer>(width, height, options);
+    if (status == 0) {
+      MMS::flush();
+    }
+  } catch (const std::exception& e) {
+    if (replay) {
+      // a divergence, or the failure the recorded run ended with
+      log("Replay stopped at record " + std::to_string(replay->get_index()) + ": " + e.what());
+      return 2;
+    }
+    // a crash or a lost simulator; the walls that led there are not tried
+    // again, the next run explores from scratch
+    log(std::string("Run failed: ") + e.what());
+    if (!options.checkpoint.empty() && std::remove(options.checkpoint.c_str()) == 0) {
+      log("Checkpoint " + options.checkpoint + " dropped");
+    }
+    return 1;
+  }
+  if (replay) {
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (!replay->at_end()) {
+      log("Replay: the solver stopped at record " + std::to_string(replay->get_index()) +
+          ", before the end of the trace");
+      return 2;
+    }
+    log("Replay: " + std::to_string(replay->get_index()) + " records matched in " +
+        std::to_string(elapsed.count() * 1e3) + " ms");
+  }
+  if (status != 0) {
+    return status;
+  }
+
+  if (maze) {
+    const auto& stats = maze->get_stats();
+    std::cout << "commands: " << stats.commands << ", moves: " << stats.moves
+              << ", turns: " << stats.turns << std::endl;
+  }
+}
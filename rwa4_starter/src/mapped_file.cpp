@@ -0,0 +1,60 @@
+#include "mapped_file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+micro_mouse::MappedFile::MappedFile(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+    }
+    struct stat status {};
+    if (::fstat(fd, &status) != 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::runtime_error("cannot stat " + path + ": " + std::strerror(error));
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ > 0) {
+        void *address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            const int error = errno;
+            ::close(fd);
+            throw std::runtime_error("cannot map " + path + ": " + std::strerror(error));
+        }
+        data_ = static_cast<const char *>(address);
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+micro_mouse::MappedFile::~MappedFile() {
+    release();
+}
+
+micro_mouse::MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data_{std::exchange(other.data_, nullptr)}, size_{std::exchange(other.size_, 0)} {}
+
+micro_mouse::MappedFile &micro_mouse::MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+void micro_mouse::MappedFile::release() noexcept {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char *>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
@@ -1,112 +1,437 @@
 #include "maze_api.hpp"
 
-#include <cstdlib>
 #include <iostream>
+#include <memory>
+
+#include "api_instrumentation.hpp"
+#include "maze_backend.hpp"
+#include "visualization_shadow.hpp"
+
+#ifdef RWA4_INSTRUMENT
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#endif
+
+namespace {
+
+// Per thread, so that batch tools can drive one in-process maze per thread;
+// the mms text pipe itself is shared, it is the process' stdin and stdout
+thread_local micro_mouse::MazeBackend *active_backend = nullptr;
+thread_local std::unique_ptr<micro_mouse::VisualizationShadow> shadow;
+
+micro_mouse::MazeBackend &backend() {
+    static micro_mouse::TextPipeBackend text_pipe;
+    return active_backend != nullptr ? *active_backend : text_pipe;
+}
+
+// Commands told apart by the instrumentation; the ones before SET_WALL wait
+// for a reply
+enum class Command {
+    MAZE_WIDTH,
+    MAZE_HEIGHT,
+    WALL_FRONT,
+    WALL_RIGHT,
+    WALL_LEFT,
+    MOVE_FORWARD,
+    TURN_RIGHT,
+    TURN_LEFT,
+    WAS_RESET,
+    ACK_RESET,
+    STEP,
+    SET_WALL,
+    CLEAR_WALL,
+    SET_COLOR,
+    CLEAR_COLOR,
+    CLEAR_ALL_COLOR,
+    SET_TEXT,
+    CLEAR_TEXT,
+    CLEAR_ALL_TEXT,
+    COUNT
+};
+
+#ifdef RWA4_INSTRUMENT
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kCommands = static_cast<int>(Command::COUNT);
+constexpr const char *kCommandNames[kCommands] = {
+    "mazeWidth", "mazeHeight", "wallFront",     "wallRight", "wallLeft",  "moveForward",  "turnRight",
+    "turnLeft",  "wasReset",   "ackReset",      "step",      "setWall",   "clearWall",    "setColor",
+    "clearColor", "clearAllColor", "setText",   "clearText", "clearAllText"};
+// latency bucket b counts round trips of [2^b, 2^(b+1)) ns
+constexpr int kBuckets = 40;
+
+struct CommandStats {
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> total_ns{0};
+    std::atomic<std::uint64_t> max_ns{0};
+    std::atomic<std::uint64_t> buckets[kBuckets]{};
+};
+
+// Shared by all threads; relaxed atomics, as the counts are only read by
+// dump()
+class Recorder {
+public:
+    Recorder() = default;
+    Recorder(const Recorder &) = delete;
+    Recorder &operator=(const Recorder &) = delete;
+    ~Recorder() { dump("exit"); }
+
+    void count(Command command) noexcept {
+        stats(command).count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void time(Command command, std::uint64_t ns) noexcept {
+        CommandStats &entry = stats(command);
+        entry.total_ns.fetch_add(ns, std::memory_order_relaxed);
+        std::uint64_t longest = entry.max_ns.load(std::memory_order_relaxed);
+        while (ns > longest && !entry.max_ns.compare_exchange_weak(longest, ns, std::memory_order_relaxed)) {
+        }
+        const int bucket = ns == 0 ? 0 : std::min(63 - __builtin_clzll(ns), kBuckets - 1);
+        entry.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Print the summary since the last dump on stderr, then start over
+    void dump(const char *when);
+
+    std::atomic<std::uint64_t> bytes_written{0};
+    std::atomic<std::uint64_t> bytes_read{0};
+
+private:
+    CommandStats &stats(Command command) noexcept { return commands_[static_cast<int>(command)]; }
+
+    CommandStats commands_[kCommands];
+};
+
+// Upper bound of a latency bucket, in microseconds
+double bucket_us(int bucket) {
+    return static_cast<double>(std::uint64_t{2} << bucket) / 1e3;
+}
+
+// Smallest bucket bound below which a fraction of the samples falls
+double percentile_us(const std::uint64_t (&buckets)[kBuckets], std::uint64_t samples, double fraction) {
+    std::uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+        seen += buckets[b];
+        if (static_cast<double>(seen) >= fraction * static_cast<double>(samples)) {
+            return bucket_us(b);
+        }
+    }
+    return bucket_us(kBuckets - 1);
+}
+
+void Recorder::dump(const char *when) {
+    std::uint64_t counts[kCommands];
+    std::uint64_t total = 0;
+    for (int c = 0; c < kCommands; ++c) {
+        counts[c] = commands_[c].count.exchange(0, std::memory_order_relaxed);
+        // the commands of a step are counted by type already
+        total += c == static_cast<int>(Command::STEP) ? 0 : counts[c];
+    }
+    const std::uint64_t written = bytes_written.exchange(0, std::memory_order_relaxed);
+    const std::uint64_t read = bytes_read.exchange(0, std::memory_order_relaxed);
+    if (total == 0) {
+        return;
+    }
+    std::ostream &out = std::cerr;
+    const auto flags = out.flags();
+    out << "MazeControlAPI at " << when << ": " << total << " commands, " << written << " bytes written, " << read
+        << " bytes read\n"
+        << std::left << std::setw(14) << "command" << std::right << std::setw(10) << "count" << std::setw(12)
+        << "mean_us" << std::setw(12) << "p50_us<=" << std::setw(12) << "p99_us<=" << std::setw(12) << "max_us"
+        << '\n'
+        << std::fixed << std::setprecision(2);
+    std::uint64_t all[kBuckets] = {};
+    for (int c = 0; c < kCommands; ++c) {
+        CommandStats &entry = commands_[c];
+        std::uint64_t buckets[kBuckets];
+        std::uint64_t samples = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            buckets[b] = entry.buckets[b].exchange(0, std::memory_order_relaxed);
+            samples += buckets[b];
+            all[b] += buckets[b];
+        }
+        const std::uint64_t total_ns = entry.total_ns.exchange(0, std::memory_order_relaxed);
+        const std::uint64_t max_ns = entry.max_ns.exchange(0, std::memory_order_relaxed);
+        if (counts[c] == 0) {
+            continue;
+        }
+        out << std::left << std::setw(14) << kCommandNames[c] << std::right << std::setw(10) << counts[c];
+        if (samples > 0) {
+            out << std::setw(12) << static_cast<double>(total_ns) / static_cast<double>(samples) / 1e3
+                << std::setw(12) << percentile_us(buckets, samples, 0.5) << std::setw(12)
+                << percentile_us(buckets, samples, 0.99) << std::setw(12) << static_cast<double>(max_ns) / 1e3;
+        }
+        out << '\n';
+    }
+    // one bar per latency bucket, over all the commands with a reply
+    const std::uint64_t peak = *std::max_element(std::begin(all), std::end(all));
+    for (int b = 0; b < kBuckets && peak > 0; ++b) {
+        if (all[b] == 0) {
+            continue;
+        }
+        out << "  < " << std::setw(10) << bucket_us(b) << " us " << std::setw(10) << all[b] << ' '
+            << std::string(static_cast<std::size_t>((all[b] * 50 + peak - 1) / peak), '#') << '\n';
+    }
+    out.flush();
+    out.flags(flags);
+}
+
+// Constant-initialized, so it can count before main(); destroyed after the
+// text pipe flushed its last commands
+Recorder recorder;
+thread_local Clock::time_point step_posted;
+thread_local bool reset_reported = false;
+
+// Counts one command and, when it waits for a reply, times it until the end
+// of the scope
+class Probe {
+public:
+    explicit Probe(Command command) noexcept
+        : command_{command}, start_{command < Command::SET_WALL ? Clock::now() : Clock::time_point{}} {
+        recorder.count(command);
+    }
+    Probe(const Probe &) = delete;
+    Probe &operator=(const Probe &) = delete;
+    ~Probe() {
+        if (command_ < Command::SET_WALL) {
+            recorder.time(command_, elapsed_ns(start_));
+        }
+    }
+
+    static std::uint64_t elapsed_ns(Clock::time_point start) noexcept {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    }
+
+private:
+    Command command_;
+    Clock::time_point start_;
+};
+
+// The commands of a posted step are counted by type, in the order the text
+// pipe sends them; the step itself is timed from post_step() to the end of
+// wait_step(), as the commands in it share one round trip
+void step_sent(const micro_mouse::StepCommand &step) noexcept {
+    switch (step.turns & 3) {
+    case 1:
+        recorder.count(Command::TURN_RIGHT);
+        break;
+    case 2:
+        recorder.count(Command::TURN_RIGHT);
+        recorder.count(Command::TURN_RIGHT);
+        break;
+    case 3:
+        recorder.count(Command::TURN_LEFT);
+        break;
+    default:
+        break;
+    }
+    if (step.distance != 0) {
+        recorder.count(Command::MOVE_FORWARD);
+    }
+    if (step.check_reset) {
+        recorder.count(Command::WAS_RESET);
+    }
+    if (step.sense & 1U) {
+        recorder.count(Command::WALL_LEFT);
+    }
+    if (step.sense & 2U) {
+        recorder.count(Command::WALL_FRONT);
+    }
+    if (step.sense & 4U) {
+        recorder.count(Command::WALL_RIGHT);
+    }
+    recorder.count(Command::STEP);
+    step_posted = Clock::now();
+}
+
+void step_answered() noexcept {
+    recorder.time(Command::STEP, Probe::elapsed_ns(step_posted));
+}
+
+// Dump once per reset, when was_reset() first reports it
+void reset_seen(bool reset) {
+    if (reset && !reset_reported) {
+        recorder.dump("reset");
+    }
+    reset_reported = reset;
+}
+
+#else
+
+class Probe {
+public:
+    explicit Probe(Command) noexcept {}
+};
+
+void step_sent(const micro_mouse::StepCommand &) noexcept {}
+void step_answered() noexcept {}
+void reset_seen(bool) noexcept {}
+
+#endif
+
+} // namespace
+
+#ifdef RWA4_INSTRUMENT
+void micro_mouse::instrument_bytes_written(std::size_t bytes) noexcept {
+    recorder.bytes_written.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void micro_mouse::instrument_bytes_read(std::size_t bytes) noexcept {
+    recorder.bytes_read.fetch_add(bytes, std::memory_order_relaxed);
+}
+#endif
+
+void micro_mouse::MazeControlAPI::set_backend(MazeBackend *backend) {
+    active_backend = backend;
+}
+
+micro_mouse::MazeBackend &micro_mouse::MazeControlAPI::get_backend() {
+    return backend();
+}
 
 int micro_mouse::MazeControlAPI::get_maze_width() {
-    std::cout << "mazeWidth" << std::endl;
-    std::string response;
-    std::cin >> response;
-    return atoi(response.c_str());
+    const Probe probe{Command::MAZE_WIDTH};
+    return backend().get_maze_width();
 }
 
 int micro_mouse::MazeControlAPI::get_maze_height() {
-    std::cout << "mazeHeight" << std::endl;
-    std::string response;
-    std::cin >> response;
-    return atoi(response.c_str());
+    const Probe probe{Command::MAZE_HEIGHT};
+    return backend().get_maze_height();
 }
 
 bool micro_mouse::MazeControlAPI::has_wall_front() {
-    std::cout << "wallFront" << std::endl;
-    std::string response;
-    std::cin >> response;
-    return response == "true";
+    const Probe probe{Command::WALL_FRONT};
+    return backend().has_wall_front();
 }
 
 bool micro_mouse::MazeControlAPI::has_wall_right() {
-    std::cout << "wallRight" << std::endl;
-    std::string response;
-    std::cin >> response;
-    return response == "true";
+    const Probe probe{Command::WALL_RIGHT};
+    return backend().has_wall_right();
 }
 
 bool micro_mouse::MazeControlAPI::has_wall_left() {
-    std::cout << "wallLeft" << std::endl;
-    std::string response;
-    std::cin >> response;
-    return response == "true";
+    const Probe probe{Command::WALL_LEFT};
+    return backend().has_wall_left();
 }
 
 void micro_mouse::MazeControlAPI::move_forward(int distance) {
-    std::cout << "moveForward ";
-    // Don't print distance argument unless explicitly specified, for
-    // backwards compatibility with older versions of the simulator
-    if (distance != 1) {
-        std::cout << distance;
-    }
-    std::cout << std::endl;
-    std::string response;
-    std::cin >> response;
-    if (response != "ack") {
-        std::cerr << response << std::endl;
-        throw;
-    }
+    const Probe probe{Command::MOVE_FORWARD};
+    backend().move_forward(distance);
 }
 
 void micro_mouse::MazeControlAPI::turn_right() {
-    std::cout << "turnRight" << std::endl;
-    std::string ack;
-    std::cin >> ack;
+    const Probe probe{Command::TURN_RIGHT};
+    backend().turn_right();
 }
 
 void micro_mouse::MazeControlAPI::turn_left() {
-    std::cout << "turnLeft" << std::endl;
-    std::string ack;
-    std::cin >> ack;
+    const Probe probe{Command::TURN_LEFT};
+    backend().turn_left();
 }
 
 void micro_mouse::MazeControlAPI::set_wall(int x, int y, char direction) {
-    std::cout << "setWall " << x << " " << y << " " << direction << std::endl;
+    if (!shadow || shadow->set_wall(x, y, direction)) {
+        const Probe probe{Command::SET_WALL};
+        backend().set_wall(x, y, direction);
+    }
 }
 
 void micro_mouse::MazeControlAPI::clear_wall(int x, int y, char direction) {
-    std::cout << "clearWall " << x << " " << y << " " << direction << std::endl;
+    if (!shadow || shadow->clear_wall(x, y, direction)) {
+        const Probe probe{Command::CLEAR_WALL};
+        backend().clear_wall(x, y, direction);
+    }
 }
 
 void micro_mouse::MazeControlAPI::set_color(int x, int y, char color) {
-    std::cout << "setColor " << x << " " << y << " " << color << std::endl;
+    if (!shadow || shadow->set_color(x, y, color)) {
+        const Probe probe{Command::SET_COLOR};
+        backend().set_color(x, y, color);
+    }
 }
 
 void micro_mouse::MazeControlAPI::clear_color(int x, int y) {
-    std::cout << "clearColor " << x << " " << y << std::endl;
+    if (!shadow || shadow->clear_color(x, y)) {
+        const Probe probe{Command::CLEAR_COLOR};
+        backend().clear_color(x, y);
+    }
 }
 
 void micro_mouse::MazeControlAPI::clear_all_color() {
-    std::cout << "clearAllColor" << std::endl;
+    if (!shadow || shadow->clear_all_color()) {
+        const Probe probe{Command::CLEAR_ALL_COLOR};
+        backend().clear_all_color();
+    }
 }
 
 void micro_mouse::MazeControlAPI::set_text(int x, int y, const std::string& text) {
-    std::cout << "setText " << x << " " << y << " " << text << std::endl;
+    if (!shadow || shadow->set_text(x, y, text)) {
+        const Probe probe{Command::SET_TEXT};
+        backend().set_text(x, y, text);
+    }
 }
 
 void micro_mouse::MazeControlAPI::clear_text(int x, int y) {
-    std::cout << "clearText " << x << " " << y << std::endl;
+    if (!shadow || shadow->clear_text(x, y)) {
+        const Probe probe{Command::CLEAR_TEXT};
+        backend().clear_text(x, y);
+    }
 }
 
 void micro_mouse::MazeControlAPI::clear_all_text() {
-    std::cout << "clearAllText" << std::endl;
+    if (!shadow || shadow->clear_all_text()) {
+        const Probe probe{Command::CLEAR_ALL_TEXT};
+        backend().clear_all_text();
+    }
 }
 
 bool micro_mouse::MazeControlAPI::was_reset() {
-    std::cout << "wasReset" << std::endl;
-    std::string response;
-    std::cin >> response;
-    return response == "true";
+    bool reset = false;
+    {
+        const Probe probe{Command::WAS_RESET};
+        reset = backend().was_reset();
+    }
+    reset_seen(reset);
+    return reset;
 }
 
 void micro_mouse::MazeControlAPI::ack_reset() {
-    std::cout << "ackReset" << std::endl;
-    std::string ack;
-    std::cin >> ack;
-}
\ No newline at end of file
+    const Probe probe{Command::ACK_RESET};
+    backend().ack_reset();
+}
+
+void micro_mouse::MazeControlAPI::post_step(const StepCommand &step) {
+    step_sent(step);
+    backend().post_step(step);
+}
+
+micro_mouse::StepReply micro_mouse::MazeControlAPI::wait_step() {
+    const StepReply reply = backend().wait_step();
+    step_answered();
+    return reply;
+}
+
+void micro_mouse::MazeControlAPI::set_shadow_enabled(bool enabled) {
+    shadow = enabled ? std::make_unique<VisualizationShadow>() : nullptr;
+}
+
+const micro_mouse::VisualizationShadow *micro_mouse::MazeControlAPI::get_shadow() {
+    return shadow.get();
+}
+
+void micro_mouse::MazeControlAPI::set_buffered_visualization(bool buffered) {
+    backend().set_buffered_visualization(buffered);
+}
+
+void micro_mouse::MazeControlAPI::flush() {
+    backend().flush();
+}
+
+void micro_mouse::MazeControlAPI::log(std::string_view text) {
+    std::cerr << text << std::endl;
+}
@@ -0,0 +1,54 @@
+#include "maze_backend.hpp"
+
+#include <stdexcept>
+
+void micro_mouse::MazeBackend::post_step(const StepCommand &step) {
+    if (step_posted_) {
+        throw std::runtime_error("a step is already in flight");
+    }
+    step_ = step;
+    step_posted_ = true;
+}
+
+micro_mouse::StepCommand micro_mouse::MazeBackend::take_step() {
+    if (!step_posted_) {
+        throw std::runtime_error("no step in flight");
+    }
+    step_posted_ = false;
+    return step_;
+}
+
+micro_mouse::StepReply micro_mouse::MazeBackend::wait_step() {
+    const StepCommand step = take_step();
+    switch (step.turns & 3) {
+    case 1:
+        turn_right();
+        break;
+    case 2:
+        turn_right();
+        turn_right();
+        break;
+    case 3:
+        turn_left();
+        break;
+    default:
+        break;
+    }
+    if (step.distance != 0) {
+        move_forward(step.distance);
+    }
+    StepReply reply;
+    if (step.check_reset) {
+        reply.reset = was_reset();
+    }
+    if (step.sense & 1U) {
+        reply.wall_left = has_wall_left();
+    }
+    if (step.sense & 2U) {
+        reply.wall_front = has_wall_front();
+    }
+    if (step.sense & 4U) {
+        reply.wall_right = has_wall_right();
+    }
+    return reply;
+}
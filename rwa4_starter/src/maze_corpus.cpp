@@ -0,0 +1,126 @@
+#include "maze_corpus.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr char kMagic[8] = {'R', 'W', 'A', '4', 'M', 'A', 'Z', 'E'};
+constexpr std::uint32_t kVersion = 1;
+// reads back differently on a host of the other byte order
+constexpr std::uint32_t kByteOrder = 0x01020304;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t count;
+};
+
+} // namespace
+
+struct micro_mouse::MazeCorpus::Entry {
+    std::uint64_t walls_offset; // packed walls, from the start of the file
+    std::uint64_t name_offset;
+    std::uint32_t name_length;
+    std::uint16_t width;
+    std::uint16_t height;
+};
+
+micro_mouse::MazeCorpus::MazeCorpus(const std::string &path) : file_{path} {
+    static_assert(sizeof(Header) == 24 && sizeof(Entry) == 24, "corpus layout");
+    Header header{};
+    if (file_.size() < sizeof(Header)) {
+        throw std::runtime_error(path + ": not a maze corpus");
+    }
+    std::memcpy(&header, file_.data(), sizeof(Header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.byte_order != kByteOrder) {
+        throw std::runtime_error(path + ": not a maze corpus");
+    }
+    if (header.version != kVersion) {
+        throw std::runtime_error(path + ": unsupported maze corpus version");
+    }
+    if (header.count > (file_.size() - sizeof(Header)) / sizeof(Entry)) {
+        throw std::runtime_error(path + ": truncated maze corpus");
+    }
+    count_ = static_cast<std::size_t>(header.count);
+    for (std::size_t maze = 0; maze < count_; ++maze) {
+        const Entry &e = entry(maze);
+        const std::uint64_t packed = (static_cast<std::uint64_t>(e.width) * e.height + 1) / 2;
+        if (e.width == 0 || e.height == 0 || e.walls_offset > file_.size() || packed > file_.size() - e.walls_offset ||
+            e.name_offset > file_.size() || e.name_length > file_.size() - e.name_offset) {
+            throw std::runtime_error(path + ": truncated maze corpus");
+        }
+    }
+}
+
+const micro_mouse::MazeCorpus::Entry &micro_mouse::MazeCorpus::entry(std::size_t maze) const noexcept {
+    // the index starts 8-byte aligned right after the header
+    return reinterpret_cast<const Entry *>(file_.data() + sizeof(Header))[maze];
+}
+
+std::string_view micro_mouse::MazeCorpus::get_name(std::size_t maze) const noexcept {
+    const Entry &e = entry(maze);
+    return {file_.data() + e.name_offset, e.name_length};
+}
+
+int micro_mouse::MazeCorpus::get_width(std::size_t maze) const noexcept {
+    return entry(maze).width;
+}
+
+int micro_mouse::MazeCorpus::get_height(std::size_t maze) const noexcept {
+    return entry(maze).height;
+}
+
+micro_mouse::MazeSimulator micro_mouse::MazeCorpus::load(std::size_t maze) const {
+    const Entry &e = entry(maze);
+    return MazeSimulator::from_packed(e.width, e.height,
+                                      reinterpret_cast<const std::uint8_t *>(file_.data() + e.walls_offset));
+}
+
+void micro_mouse::MazeCorpus::write(const std::string &path, const std::vector<std::string> &names,
+                                    const std::vector<MazeSimulator> &mazes) {
+    if (names.size() != mazes.size()) {
+        throw std::invalid_argument("one name per maze is needed");
+    }
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrder;
+    header.count = mazes.size();
+
+    // header, index, packed walls, names
+    std::vector<Entry> index(mazes.size());
+    std::uint64_t offset = sizeof(Header) + sizeof(Entry) * mazes.size();
+    for (std::size_t maze = 0; maze < mazes.size(); ++maze) {
+        if (mazes[maze].get_width() > 0xFFFF || mazes[maze].get_height() > 0xFFFF) {
+            throw std::invalid_argument("maze too large for the corpus format");
+        }
+        index[maze].width = static_cast<std::uint16_t>(mazes[maze].get_width());
+        index[maze].height = static_cast<std::uint16_t>(mazes[maze].get_height());
+        index[maze].walls_offset = offset;
+        offset += mazes[maze].get_packed_size();
+    }
+    for (std::size_t maze = 0; maze < mazes.size(); ++maze) {
+        index[maze].name_offset = offset;
+        index[maze].name_length = static_cast<std::uint32_t>(names[maze].size());
+        offset += names[maze].size();
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(index.data()), static_cast<std::streamsize>(sizeof(Entry) * index.size()));
+    std::vector<std::uint8_t> packed;
+    for (const auto &maze : mazes) {
+        packed.resize(maze.get_packed_size());
+        maze.pack(packed.data());
+        file.write(reinterpret_cast<const char *>(packed.data()), static_cast<std::streamsize>(packed.size()));
+    }
+    for (const auto &name : names) {
+        file.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+    if (!file.flush()) {
+        throw std::runtime_error("cannot write maze corpus " + path);
+    }
+}
@@ -0,0 +1,306 @@
+#include "maze_generator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+
+constexpr int kAttempts = 16;
+
+constexpr std::uint8_t bit(micro_mouse::Direction direction) {
+    return static_cast<std::uint8_t>(1U << static_cast<int>(direction));
+}
+
+// Whether a wall follower starting at (0, 0) facing north enters the center
+bool follower_reaches_center(const micro_mouse::MazeSimulator &maze, bool left_hand) {
+    using micro_mouse::Direction;
+    micro_mouse::Pose pose;
+    // every step changes the (cell, heading) state, so more steps than
+    // states means the follower is going round in circles
+    const int states = 4 * maze.get_width() * maze.get_height();
+    for (int step = 0; step <= states; ++step) {
+        if (maze.is_goal(pose.x, pose.y)) {
+            return true;
+        }
+        const Direction hand = left_hand ? micro_mouse::turn_left(pose.heading) : micro_mouse::turn_right(pose.heading);
+        if (!maze.has_wall(pose.x, pose.y, hand)) {
+            pose.heading = hand;
+        } else if (maze.has_wall(pose.x, pose.y, pose.heading)) {
+            pose.heading = left_hand ? micro_mouse::turn_right(pose.heading) : micro_mouse::turn_left(pose.heading);
+            continue;
+        }
+        pose.x += micro_mouse::dx(pose.heading);
+        pose.y += micro_mouse::dy(pose.heading);
+    }
+    return false;
+}
+
+} // namespace
+
+micro_mouse::RuleCheck micro_mouse::check_rules(const MazeSimulator &maze) {
+    const int width = maze.get_width();
+    const int height = maze.get_height();
+    RuleCheck check;
+
+    check.enclosed = true;
+    for (int x = 0; x < width; ++x) {
+        check.enclosed = check.enclosed && maze.has_wall(x, 0, Direction::SOUTH) &&
+                         maze.has_wall(x, height - 1, Direction::NORTH);
+    }
+    for (int y = 0; y < height; ++y) {
+        check.enclosed = check.enclosed && maze.has_wall(0, y, Direction::WEST) &&
+                         maze.has_wall(width - 1, y, Direction::EAST);
+    }
+
+    check.start_walls = maze.has_wall(0, 0, Direction::WEST) && maze.has_wall(0, 0, Direction::SOUTH) &&
+                        maze.has_wall(0, 0, Direction::EAST) && !maze.has_wall(0, 0, Direction::NORTH);
+
+    // walls between two center cells, and openings from the center to the rest
+    check.hollow_center = true;
+    int entrances = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (!maze.is_goal(x, y)) {
+                continue;
+            }
+            for (int d = 0; d < 4; ++d) {
+                const auto direction = static_cast<Direction>(d);
+                const int nx = x + dx(direction);
+                const int ny = y + dy(direction);
+                const bool wall = maze.has_wall(x, y, direction);
+                if (maze.is_goal(nx, ny) && nx >= 0 && ny >= 0 && nx < width && ny < height) {
+                    check.hollow_center = check.hollow_center && !wall;
+                } else if (!wall) {
+                    ++entrances;
+                }
+            }
+        }
+    }
+    check.single_entrance = entrances == 1;
+
+    check.not_wall_followable = !follower_reaches_center(maze, true) && !follower_reaches_center(maze, false);
+    return check;
+}
+
+micro_mouse::MazeSimulator micro_mouse::MazeGenerator::generate(const Options &options) {
+    if (options.width < 3 || options.height < 3) {
+        throw std::invalid_argument("generated mazes must be at least 3 x 3");
+    }
+    width_ = options.width;
+    height_ = options.height;
+    center_x0_ = (width_ - 1) / 2;
+    center_x1_ = width_ / 2;
+    center_y0_ = (height_ - 1) / 2;
+    center_y1_ = height_ / 2;
+
+    for (int attempt = 0; attempt < kAttempts; ++attempt) {
+        carve();
+        if (!options.perfect) {
+            if (options.enforce_rules && !detach_center()) {
+                continue;
+            }
+            open_extra(options.extra_openings);
+        }
+        const auto cells = walls_.size();
+        packed_.assign((cells + 1) / 2, 0);
+        for (std::size_t cell = 0; cell < cells; ++cell) {
+            packed_[cell / 2] |= static_cast<std::uint8_t>(walls_[cell] << (4 * (cell % 2)));
+        }
+        return MazeSimulator::from_packed(width_, height_, packed_.data());
+    }
+    throw std::runtime_error("cannot generate a maze meeting the rules at this size");
+}
+
+std::uint32_t micro_mouse::MazeGenerator::random_below(std::uint32_t bound) {
+    // multiply-shift instead of a division, the bias is negligible here
+    return static_cast<std::uint32_t>(((rng_() >> 32) * bound) >> 32);
+}
+
+void micro_mouse::MazeGenerator::carve() {
+    const int cells = width_ * height_;
+    walls_.assign(static_cast<std::size_t>(cells), 0xF);
+    visited_.assign(static_cast<std::size_t>(cells), 0);
+    stack_.clear();
+
+    // the center block is a single room, entered once from the carve
+    for (int y = center_y0_; y <= center_y1_; ++y) {
+        for (int x = center_x0_; x <= center_x1_; ++x) {
+            if (x < center_x1_) {
+                open(x, y, Direction::EAST);
+            }
+            if (y < center_y1_) {
+                open(x, y, Direction::NORTH);
+            }
+        }
+    }
+    // the start cell only opens to the north
+    visited_[0] = 1;
+    open(0, 0, Direction::NORTH);
+    visited_[static_cast<std::size_t>(width_)] = 1;
+    stack_.push_back(pack_xy(0, 1));
+
+    while (!stack_.empty()) {
+        const int x = stack_.back() & 0xFFFF;
+        const int y = stack_.back() >> 16;
+        const int cell = y * width_ + x;
+        Direction candidates[4];
+        std::uint32_t count = 0;
+        if (y + 1 < height_ && visited_[static_cast<std::size_t>(cell + width_)] == 0) {
+            candidates[count++] = Direction::NORTH;
+        }
+        if (x + 1 < width_ && visited_[static_cast<std::size_t>(cell + 1)] == 0) {
+            candidates[count++] = Direction::EAST;
+        }
+        if (y > 0 && visited_[static_cast<std::size_t>(cell - width_)] == 0) {
+            candidates[count++] = Direction::SOUTH;
+        }
+        if (x > 0 && visited_[static_cast<std::size_t>(cell - 1)] == 0) {
+            candidates[count++] = Direction::WEST;
+        }
+        if (count == 0) {
+            stack_.pop_back();
+            continue;
+        }
+        const Direction direction = candidates[count == 1 ? 0 : random_below(count)];
+        const int nx = x + dx(direction);
+        const int ny = y + dy(direction);
+        open(x, y, direction);
+        if (in_center(nx, ny)) {
+            // a dead end for the carve: the room gets no second entrance
+            for (int cy = center_y0_; cy <= center_y1_; ++cy) {
+                for (int cx = center_x0_; cx <= center_x1_; ++cx) {
+                    visited_[static_cast<std::size_t>(cy * width_ + cx)] = 1;
+                }
+            }
+        } else {
+            visited_[static_cast<std::size_t>(ny * width_ + nx)] = 1;
+            stack_.push_back(pack_xy(nx, ny));
+        }
+    }
+}
+
+void micro_mouse::MazeGenerator::open(int x, int y, Direction direction) noexcept {
+    const int cell = y * width_ + x;
+    const int neighbour = cell + dx(direction) + dy(direction) * width_;
+    walls_[static_cast<std::size_t>(cell)] &= static_cast<std::uint8_t>(~bit(direction));
+    walls_[static_cast<std::size_t>(neighbour)] &= static_cast<std::uint8_t>(~bit(opposite(direction)));
+}
+
+bool micro_mouse::MazeGenerator::is_protected(int x, int y, Direction direction) const noexcept {
+    const int nx = x + dx(direction);
+    const int ny = y + dy(direction);
+    if (nx < 0 || ny < 0 || nx >= width_ || ny >= height_) {
+        return true;
+    }
+    // the east wall of the start cell, and the walls around the center
+    const bool start = (x == 0 && y == 0 && direction == Direction::EAST) ||
+                       (nx == 0 && ny == 0 && direction == Direction::WEST);
+    return start || in_center(x, y) != in_center(nx, ny);
+}
+
+bool micro_mouse::MazeGenerator::detach_center() {
+    // Posts are the corners of the cells, (width + 1) x (height + 1). Walls
+    // link posts; a wall follower follows the posts linked to the outer wall,
+    // so the posts around the center must not be among them. Each round
+    // finds a chain of walls from the outer wall to the center and opens one
+    // of its walls at random; in a perfect maze one cut is enough.
+    const int columns = width_ + 1;
+    const int posts = columns * (height_ + 1);
+    auto has = [this](int x, int y, Direction direction) {
+        return (walls_[static_cast<std::size_t>(y * width_ + x)] & bit(direction)) != 0;
+    };
+    auto around_center = [this](int px, int py) {
+        return px >= center_x0_ && px <= center_x1_ + 1 && py >= center_y0_ && py <= center_y1_ + 1;
+    };
+
+    for (int round = 0; round < width_ * height_; ++round) {
+        // breadth-first from every post of the outer wall; parents_ holds the
+        // post each one was reached from, -1 on the outer wall
+        parents_.assign(static_cast<std::size_t>(posts), -2);
+        queue_.clear();
+        for (int px = 0; px <= width_; ++px) {
+            queue_.push_back(pack_xy(px, 0));
+            queue_.push_back(pack_xy(px, height_));
+        }
+        for (int py = 1; py < height_; ++py) {
+            queue_.push_back(pack_xy(0, py));
+            queue_.push_back(pack_xy(width_, py));
+        }
+        for (const int p : queue_) {
+            parents_[static_cast<std::size_t>((p >> 16) * columns + (p & 0xFFFF))] = -1;
+        }
+        int reached = -1;
+        for (std::size_t head = 0; head < queue_.size() && reached < 0; ++head) {
+            const int px = queue_[head] & 0xFFFF;
+            const int py = queue_[head] >> 16;
+            const int p = py * columns + px;
+            // the up to four inner walls ending at this post
+            auto visit = [&](int nx, int ny) {
+                int &parent = parents_[static_cast<std::size_t>(ny * columns + nx)];
+                if (parent == -2) {
+                    parent = p;
+                    queue_.push_back(pack_xy(nx, ny));
+                    if (around_center(nx, ny)) {
+                        reached = ny * columns + nx;
+                    }
+                }
+            };
+            const bool inner_x = px >= 1 && px < width_;
+            const bool inner_y = py >= 1 && py < height_;
+            if (inner_x && py < height_ && has(px - 1, py, Direction::EAST)) {
+                visit(px, py + 1);
+            }
+            if (inner_x && py >= 1 && has(px - 1, py - 1, Direction::EAST)) {
+                visit(px, py - 1);
+            }
+            if (inner_y && px < width_ && has(px, py - 1, Direction::NORTH)) {
+                visit(px + 1, py);
+            }
+            if (inner_y && px >= 1 && has(px - 1, py - 1, Direction::NORTH)) {
+                visit(px - 1, py);
+            }
+        }
+        if (reached < 0) {
+            return true;
+        }
+
+        // walls of the chain that may be opened, as (x, y, east or north)
+        stack_.clear();
+        for (int p = reached; parents_[static_cast<std::size_t>(p)] >= 0; p = parents_[static_cast<std::size_t>(p)]) {
+            const int q = parents_[static_cast<std::size_t>(p)];
+            const int px = std::min(p, q) % columns;
+            const int py = std::min(p, q) / columns;
+            // vertical links are east walls, horizontal links north walls
+            const bool east = std::abs(p - q) == columns;
+            const int x = px - (east ? 1 : 0);
+            const int y = py - (east ? 0 : 1);
+            if (!is_protected(x, y, east ? Direction::EAST : Direction::NORTH)) {
+                stack_.push_back(pack_xy(x, y) * 2 + (east ? 0 : 1));
+            }
+        }
+        if (stack_.empty()) {
+            return false;
+        }
+        const int wall = stack_[random_below(static_cast<std::uint32_t>(stack_.size()))];
+        open((wall / 2) & 0xFFFF, (wall / 2) >> 16, wall % 2 == 0 ? Direction::EAST : Direction::NORTH);
+    }
+    return false;
+}
+
+void micro_mouse::MazeGenerator::open_extra(double probability) {
+    if (probability <= 0.0) {
+        return;
+    }
+    std::bernoulli_distribution remove(probability);
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            for (const Direction direction : {Direction::EAST, Direction::NORTH}) {
+                if ((walls_[static_cast<std::size_t>(y * width_ + x)] & bit(direction)) != 0 &&
+                    !is_protected(x, y, direction) && remove(rng_)) {
+                    open(x, y, direction);
+                }
+            }
+        }
+    }
+}
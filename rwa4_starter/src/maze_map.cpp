@@ -0,0 +1,5 @@
+#include "maze_map.hpp"
+
+// the two maps used by the solver: 16x16 competition mazes and any other size
+template class micro_mouse::BasicMazeMap<micro_mouse::kClassicSize, micro_mouse::kClassicSize>;
+template class micro_mouse::BasicMazeMap<micro_mouse::kDynamic, micro_mouse::kDynamic>;
@@ -0,0 +1,433 @@
+#include "maze_simulator.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+#include <system_error>
+
+#include "mapped_file.hpp"
+
+namespace {
+
+constexpr std::uint8_t bit(micro_mouse::Direction direction) {
+    return static_cast<std::uint8_t>(1U << static_cast<int>(direction));
+}
+
+// Character at a column of a maze file line, spaces past the end
+char char_at(std::string_view line, std::size_t column) {
+    return column < line.size() ? line[column] : ' ';
+}
+
+bool is_wall_char(char c) {
+    return c != ' ' && c != '\t';
+}
+
+// Hands out the lines of a text as views, without the line terminators
+class LineCursor {
+public:
+    explicit LineCursor(std::string_view text) noexcept : text_{text} {}
+
+    bool next(std::string_view &line) noexcept {
+        if (pos_ >= text_.size()) {
+            return false;
+        }
+        std::size_t end = text_.find('\n', pos_);
+        if (end == std::string_view::npos) {
+            end = text_.size();
+        }
+        line = text_.substr(pos_, end - pos_);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        pos_ = end + 1;
+        return true;
+    }
+
+private:
+    std::string_view text_;
+    std::size_t pos_{0};
+};
+
+bool is_blank(std::string_view line) {
+    return std::all_of(line.begin(), line.end(), [](char c) { return !is_wall_char(c); });
+}
+
+// Parse the six integers of a "num" line: x y n e s w
+bool parse_num_line(std::string_view line, int (&values)[6]) {
+    const char *pos = line.data();
+    const char *const end = line.data() + line.size();
+    for (int &value : values) {
+        while (pos != end && std::isspace(static_cast<unsigned char>(*pos))) {
+            ++pos;
+        }
+        const auto result = std::from_chars(pos, end, value);
+        if (result.ec != std::errc{}) {
+            return false;
+        }
+        pos = result.ptr;
+    }
+    return true;
+}
+
+// Split a protocol line into at most 4 space separated tokens
+int tokenize(std::string_view line, std::string_view (&tokens)[4]) {
+    int count = 0;
+    std::size_t pos = 0;
+    while (count < 4) {
+        pos = line.find_first_not_of(' ', pos);
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        std::size_t end = line.find(' ', pos);
+        if (end == std::string_view::npos || count == 3) {
+            // the last token keeps the rest of the line (setText may contain spaces)
+            end = line.size();
+        }
+        tokens[count++] = line.substr(pos, end - pos);
+        pos = end;
+    }
+    return count;
+}
+
+int to_int(std::string_view token, int fallback) {
+    int value = fallback;
+    std::from_chars(token.data(), token.data() + token.size(), value);
+    return value;
+}
+
+} // namespace
+
+micro_mouse::MazeSimulator::MazeSimulator(int width, int height)
+    : width_{width}, height_{height} {
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("maze dimensions must be positive");
+    }
+    walls_.assign(static_cast<std::size_t>(width) * static_cast<std::size_t>(height), 0);
+    for (int x = 0; x < width_; ++x) {
+        set_wall(x, 0, Direction::SOUTH, true);
+        set_wall(x, height_ - 1, Direction::NORTH, true);
+    }
+    for (int y = 0; y < height_; ++y) {
+        set_wall(0, y, Direction::WEST, true);
+        set_wall(width_ - 1, y, Direction::EAST, true);
+    }
+}
+
+micro_mouse::MazeSimulator micro_mouse::MazeSimulator::from_file(const std::string &path) {
+    // the file is parsed in place, straight from the page cache
+    const MappedFile file(path);
+    return from_text(file.view());
+}
+
+micro_mouse::MazeSimulator micro_mouse::MazeSimulator::from_text(std::string_view text) {
+    // first pass: size of the maze, ignoring trailing blank lines
+    LineCursor cursor(text);
+    std::string_view line;
+    std::string_view first;
+    std::size_t lines = 0;
+    std::size_t used_lines = 0;
+    std::size_t columns = 0;
+    std::size_t used_columns = 0;
+    while (cursor.next(line)) {
+        if (lines++ == 0) {
+            first = line;
+        }
+        columns = std::max(columns, line.size());
+        if (!is_blank(line)) {
+            used_lines = lines;
+            used_columns = columns;
+        }
+    }
+    if (used_lines == 0) {
+        throw std::runtime_error("empty maze file");
+    }
+    const std::size_t start = first.find_first_not_of(" \t");
+
+    if (start != std::string_view::npos && std::isdigit(static_cast<unsigned char>(first[start]))) {
+        // "num" format: one "x y n e s w" line per cell
+        int values[6];
+        int width = 0;
+        int height = 0;
+        std::size_t cells = 0;
+        cursor = LineCursor(text);
+        while (cursor.next(line)) {
+            if (parse_num_line(line, values)) {
+                width = std::max(width, values[0] + 1);
+                height = std::max(height, values[1] + 1);
+                ++cells;
+            }
+        }
+        if (cells == 0 || cells != static_cast<std::size_t>(width) * static_cast<std::size_t>(height)) {
+            throw std::runtime_error("malformed num maze file");
+        }
+        MazeSimulator maze(width, height);
+        cursor = LineCursor(text);
+        while (cursor.next(line)) {
+            if (parse_num_line(line, values)) {
+                for (int d = 0; d < 4; ++d) {
+                    if (values[2 + d] != 0) {
+                        maze.set_wall(values[0], values[1], static_cast<Direction>(d), true);
+                    }
+                }
+            }
+        }
+        return maze;
+    }
+
+    // "map" format: post rows and cell rows alternate, each cell is 4 columns wide
+    if (used_lines < 3 || used_lines % 2 == 0) {
+        throw std::runtime_error("malformed map maze file");
+    }
+    const int height = static_cast<int>(used_lines / 2);
+    const int width = static_cast<int>((used_columns - 1) / 4);
+    if (width <= 0) {
+        throw std::runtime_error("malformed map maze file");
+    }
+    MazeSimulator maze(width, height);
+    cursor = LineCursor(text);
+    std::string_view above;
+    std::string_view cells;
+    std::string_view below;
+    cursor.next(below);
+    for (int row = 0; row < height; ++row) {
+        const int y = height - 1 - row;
+        above = below;
+        cursor.next(cells);
+        cursor.next(below);
+        for (int x = 0; x < width; ++x) {
+            const auto column = static_cast<std::size_t>(4 * x);
+            if (is_wall_char(char_at(above, column + 2))) {
+                maze.set_wall(x, y, Direction::NORTH, true);
+            }
+            if (is_wall_char(char_at(below, column + 2))) {
+                maze.set_wall(x, y, Direction::SOUTH, true);
+            }
+            if (is_wall_char(char_at(cells, column))) {
+                maze.set_wall(x, y, Direction::WEST, true);
+            }
+            if (is_wall_char(char_at(cells, column + 4))) {
+                maze.set_wall(x, y, Direction::EAST, true);
+            }
+        }
+    }
+    return maze;
+}
+
+micro_mouse::MazeSimulator micro_mouse::MazeSimulator::from_packed(int width, int height, const std::uint8_t *packed) {
+    MazeSimulator maze(width, height);
+    const std::size_t cells = maze.walls_.size();
+    for (std::size_t cell = 0; cell < cells; ++cell) {
+        maze.walls_[cell] |= static_cast<std::uint8_t>((packed[cell / 2] >> (4 * (cell % 2))) & 0xF);
+    }
+    // a wall recorded on one side only is added to the other side
+    auto &walls = maze.walls_;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const std::size_t cell = maze.index(x, y);
+            if (x + 1 < width && (walls[cell] & bit(Direction::EAST)) != 0) {
+                walls[cell + 1] |= bit(Direction::WEST);
+            }
+            if (x > 0 && (walls[cell] & bit(Direction::WEST)) != 0) {
+                walls[cell - 1] |= bit(Direction::EAST);
+            }
+            if (y + 1 < height && (walls[cell] & bit(Direction::NORTH)) != 0) {
+                walls[cell + static_cast<std::size_t>(width)] |= bit(Direction::SOUTH);
+            }
+            if (y > 0 && (walls[cell] & bit(Direction::SOUTH)) != 0) {
+                walls[cell - static_cast<std::size_t>(width)] |= bit(Direction::NORTH);
+            }
+        }
+    }
+    return maze;
+}
+
+void micro_mouse::MazeSimulator::pack(std::uint8_t *packed) const noexcept {
+    std::fill(packed, packed + get_packed_size(), std::uint8_t{0});
+    for (std::size_t cell = 0; cell < walls_.size(); ++cell) {
+        packed[cell / 2] |= static_cast<std::uint8_t>(walls_[cell] << (4 * (cell % 2)));
+    }
+}
+
+std::uint64_t micro_mouse::MazeSimulator::get_fingerprint() const noexcept {
+    std::uint64_t hash = 14695981039346656037U;
+    auto mix = [&hash](unsigned value) { hash = (hash ^ value) * 1099511628211U; };
+    mix(static_cast<unsigned>(width_));
+    mix(static_cast<unsigned>(height_));
+    for (const std::uint8_t walls : walls_) {
+        mix(walls & 0xFU);
+    }
+    return hash;
+}
+
+std::string micro_mouse::MazeSimulator::to_text() const {
+    // post row, cell row, ..., post row: 4 columns per cell plus the last post
+    const auto columns = static_cast<std::size_t>(4 * width_ + 1);
+    std::string text;
+    text.reserve((columns + 1) * static_cast<std::size_t>(2 * height_ + 1));
+    auto post_row = [&](int y, Direction side) {
+        for (int x = 0; x < width_; ++x) {
+            text += 'o';
+            text.append(3, has_wall(x, y, side) ? '-' : ' ');
+        }
+        text += "o\n";
+    };
+    for (int y = height_ - 1; y >= 0; --y) {
+        post_row(y, Direction::NORTH);
+        for (int x = 0; x < width_; ++x) {
+            text += has_wall(x, y, Direction::WEST) ? '|' : ' ';
+            text.append(3, ' ');
+        }
+        text += has_wall(width_ - 1, y, Direction::EAST) ? "|\n" : " \n";
+    }
+    post_row(0, Direction::SOUTH);
+    return text;
+}
+
+bool micro_mouse::MazeSimulator::has_wall(int x, int y, Direction direction) const noexcept {
+    if (!inside(x, y)) {
+        return true;
+    }
+    return (walls_[index(x, y)] & bit(direction)) != 0;
+}
+
+void micro_mouse::MazeSimulator::set_wall(int x, int y, Direction direction, bool present) {
+    if (!inside(x, y)) {
+        return;
+    }
+    const int nx = x + dx(direction);
+    const int ny = y + dy(direction);
+    if (!inside(nx, ny)) {
+        // the outer boundary is always closed
+        present = true;
+    }
+    auto update = [present](std::uint8_t &cell, std::uint8_t mask) {
+        cell = present ? static_cast<std::uint8_t>(cell | mask) : static_cast<std::uint8_t>(cell & ~mask);
+    };
+    update(walls_[index(x, y)], bit(direction));
+    if (inside(nx, ny)) {
+        update(walls_[index(nx, ny)], bit(opposite(direction)));
+    }
+}
+
+bool micro_mouse::MazeSimulator::is_goal(int x, int y) const noexcept {
+    return (x == (width_ - 1) / 2 || x == width_ / 2) && (y == (height_ - 1) / 2 || y == height_ / 2);
+}
+
+bool micro_mouse::MazeSimulator::sense(Direction direction) noexcept {
+    ++stats_.commands;
+    ++stats_.wall_queries;
+    return has_wall(pose_.x, pose_.y, direction);
+}
+
+bool micro_mouse::MazeSimulator::wall_front() noexcept {
+    return sense(pose_.heading);
+}
+
+bool micro_mouse::MazeSimulator::wall_right() noexcept {
+    return sense(micro_mouse::turn_right(pose_.heading));
+}
+
+bool micro_mouse::MazeSimulator::wall_left() noexcept {
+    return sense(micro_mouse::turn_left(pose_.heading));
+}
+
+bool micro_mouse::MazeSimulator::move_forward(int distance) {
+    ++stats_.commands;
+    ++stats_.moves;
+    for (int i = 0; i < distance; ++i) {
+        if (has_wall(pose_.x, pose_.y, pose_.heading)) {
+            ++stats_.crashes;
+            return false;
+        }
+        pose_.x += dx(pose_.heading);
+        pose_.y += dy(pose_.heading);
+        ++stats_.cells_moved;
+    }
+    return true;
+}
+
+void micro_mouse::MazeSimulator::turn_right() noexcept {
+    ++stats_.commands;
+    ++stats_.turns;
+    pose_.heading = micro_mouse::turn_right(pose_.heading);
+}
+
+void micro_mouse::MazeSimulator::turn_left() noexcept {
+    ++stats_.commands;
+    ++stats_.turns;
+    pose_.heading = micro_mouse::turn_left(pose_.heading);
+}
+
+bool micro_mouse::MazeSimulator::poll_reset() noexcept {
+    ++stats_.commands;
+    return reset_requested_;
+}
+
+void micro_mouse::MazeSimulator::ack_reset() noexcept {
+    ++stats_.commands;
+    if (reset_requested_) {
+        ++stats_.episodes;
+    }
+    reset_requested_ = false;
+    pose_ = Pose{};
+}
+
+bool micro_mouse::MazeSimulator::handle(std::string_view line, std::string &reply) {
+    reply.clear();
+    std::string_view tokens[4];
+    const int count = tokenize(line, tokens);
+    if (count == 0) {
+        return false;
+    }
+    const std::string_view command = tokens[0];
+    auto reply_bool = [&reply](bool value) {
+        reply = value ? "true" : "false";
+        return true;
+    };
+
+    if (command == "wallFront") {
+        return reply_bool(wall_front());
+    }
+    if (command == "wallRight") {
+        return reply_bool(wall_right());
+    }
+    if (command == "wallLeft") {
+        return reply_bool(wall_left());
+    }
+    if (command == "moveForward") {
+        reply = move_forward(count > 1 ? to_int(tokens[1], 1) : 1) ? "ack" : "crash";
+        return true;
+    }
+    if (command == "turnRight" || command == "turnRight90") {
+        turn_right();
+        reply = "ack";
+        return true;
+    }
+    if (command == "turnLeft" || command == "turnLeft90") {
+        turn_left();
+        reply = "ack";
+        return true;
+    }
+    if (command == "wasReset") {
+        return reply_bool(poll_reset());
+    }
+    if (command == "ackReset") {
+        ack_reset();
+        reply = "ack";
+        return true;
+    }
+    // the remaining commands are counted here, mouse commands count themselves
+    ++stats_.commands;
+    if (command == "mazeWidth") {
+        reply = std::to_string(width_);
+        return true;
+    }
+    if (command == "mazeHeight") {
+        reply = std::to_string(height_);
+        return true;
+    }
+    // setWall, clearWall, setColor, clearColor, clearAllColor, setText,
+    // clearText and clearAllText only affect the display: nothing to draw here
+    return false;
+}
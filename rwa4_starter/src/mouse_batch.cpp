@@ -0,0 +1,216 @@
+#include "mouse_batch.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+constexpr std::uint8_t kGoalBit = 1U << 4;
+
+// Options of a mouse at a cell, in tie-breaking order: front, left, right,
+// back. kTurn is added to the heading, kTurnCount quarter turns are sent.
+constexpr int kOptions = 4;
+constexpr int kTurn[kOptions] = {0, 3, 1, 2};
+constexpr std::uint32_t kTurnCount[kOptions] = {0, 1, 1, 2};
+constexpr float kTurnCost[kOptions] = {0.0f, 1.0f, 1.0f, 2.0f};
+
+// Sides a mouse reads, relative to its heading: left, front and right
+constexpr int kSensed[] = {3, 0, 1};
+
+} // namespace
+
+micro_mouse::MouseBatch::MouseBatch(unsigned threads)
+    : threads_{threads != 0 ? threads : std::max(1U, std::thread::hardware_concurrency())} {}
+
+int micro_mouse::MouseBatch::add_maze(const MazeSimulator &maze) {
+    const int width = maze.get_width();
+    const int height = maze.get_height();
+    maze_width_.push_back(width);
+    maze_height_.push_back(height);
+    maze_offset_.push_back(cells_.size());
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            std::uint8_t cell = maze.is_goal(x, y) ? kGoalBit : 0;
+            int distance = std::numeric_limits<int>::max();
+            for (int d = 0; d < 4; ++d) {
+                cell |= maze.has_wall(x, y, static_cast<Direction>(d)) ? 1U << d : 0U;
+            }
+            for (const int gx : {(width - 1) / 2, width / 2}) {
+                for (const int gy : {(height - 1) / 2, height / 2}) {
+                    distance = std::min(distance, std::abs(x - gx) + std::abs(y - gy));
+                }
+            }
+            cells_.push_back(cell);
+            distances_.push_back(static_cast<std::uint16_t>(std::min(distance, 0xFFFF)));
+        }
+    }
+    return static_cast<int>(maze_width_.size()) - 1;
+}
+
+int micro_mouse::MouseBatch::add_mouse(int maze, const Heuristic &heuristic) {
+    if (maze < 0 || maze >= static_cast<int>(maze_width_.size())) {
+        throw std::out_of_range("no such maze");
+    }
+    const auto m = static_cast<std::size_t>(maze);
+    const int width = maze_width_[m];
+    const int height = maze_height_[m];
+    maze_.push_back(maze);
+    x_.push_back(0);
+    y_.push_back(0);
+    heading_.push_back(static_cast<std::uint8_t>(Direction::NORTH));
+    state_.push_back((cells_[maze_offset_[m]] & kGoalBit) != 0 ? State::GOAL : State::RUNNING);
+    moves_.push_back(0);
+    turns_.push_back(0);
+    queries_.push_back(0);
+    distance_weight_.push_back(heuristic.distance);
+    visit_weight_.push_back(heuristic.visits);
+    turn_weight_.push_back(heuristic.turns);
+    map_offset_.push_back(maps_.size());
+
+    // the outer wall is known from the start, nothing inside it
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const unsigned boundary = (y == height - 1 ? 1U << static_cast<int>(Direction::NORTH) : 0U) |
+                                      (x == width - 1 ? 1U << static_cast<int>(Direction::EAST) : 0U) |
+                                      (y == 0 ? 1U << static_cast<int>(Direction::SOUTH) : 0U) |
+                                      (x == 0 ? 1U << static_cast<int>(Direction::WEST) : 0U);
+            maps_.push_back(static_cast<std::uint8_t>(boundary));
+        }
+    }
+    visits_.resize(maps_.size(), 0);
+    // the start counts as entered once
+    visits_[map_offset_.back()] = 1;
+    return static_cast<int>(x_.size()) - 1;
+}
+
+micro_mouse::Pose micro_mouse::MouseBatch::get_pose(int mouse) const {
+    const auto i = static_cast<std::size_t>(mouse);
+    return Pose{x_.at(i), y_.at(i), static_cast<Direction>(heading_.at(i))};
+}
+
+void micro_mouse::MouseBatch::run(std::uint64_t max_steps) {
+    const std::size_t mice = x_.size();
+    const std::size_t shards = std::max<std::size_t>(1, std::min<std::size_t>(threads_, mice));
+    std::vector<std::thread> pool;
+    for (std::size_t shard = 1; shard < shards; ++shard) {
+        pool.emplace_back([this, shard, shards, mice, max_steps]() {
+            advance(mice * shard / shards, mice * (shard + 1) / shards, max_steps);
+        });
+    }
+    advance(0, mice / shards, max_steps);
+    for (auto &thread : pool) {
+        thread.join();
+    }
+}
+
+void micro_mouse::MouseBatch::advance(std::size_t begin, std::size_t end, std::uint64_t max_steps) {
+    // mice of the shard still running, compacted as they stop so that a few
+    // long runs do not drag every finished mouse through each step
+    std::vector<std::size_t> active;
+    for (std::size_t i = begin; i < end; ++i) {
+        if (state_[i] == State::RUNNING) {
+            active.push_back(i);
+        }
+    }
+    // scratch of the shard, one array per option: whether it is open, and
+    // the distance and visit count of the neighbour it leads to
+    const std::size_t count = active.size();
+    std::vector<std::size_t> cell(count);
+    std::vector<std::uint8_t> open[kOptions];
+    std::vector<float> distance[kOptions];
+    std::vector<float> visits[kOptions];
+    for (int o = 0; o < kOptions; ++o) {
+        open[o].resize(count);
+        distance[o].resize(count);
+        visits[o].resize(count);
+    }
+    std::vector<std::uint8_t> choice(count);
+    std::vector<float> distance_weight(count);
+    std::vector<float> visit_weight(count);
+    std::vector<float> turn_weight(count);
+    for (std::size_t k = 0; k < count; ++k) {
+        distance_weight[k] = distance_weight_[active[k]];
+        visit_weight[k] = visit_weight_[active[k]];
+        turn_weight[k] = turn_weight_[active[k]];
+    }
+
+    for (std::uint64_t step = 0; step < max_steps && !active.empty(); ++step) {
+        // read the walls around each mouse into its map
+        for (std::size_t k = 0; k < active.size(); ++k) {
+            const std::size_t i = active[k];
+            const auto m = static_cast<std::size_t>(maze_[i]);
+            cell[k] = static_cast<std::size_t>(y_[i] * maze_width_[m] + x_[i]);
+            const std::uint8_t walls = cells_[maze_offset_[m] + cell[k]];
+            unsigned seen = 0;
+            for (const int turn : kSensed) {
+                seen |= walls & (1U << ((heading_[i] + turn) & 3));
+            }
+            maps_[map_offset_[i] + cell[k]] |= static_cast<std::uint8_t>(seen);
+            queries_[i] += 3;
+        }
+
+        // gather what the heuristic looks at; blocked options look at the
+        // cell itself, so that no index leaves the maze
+        for (int o = 0; o < kOptions; ++o) {
+            for (std::size_t k = 0; k < active.size(); ++k) {
+                const std::size_t i = active[k];
+                const auto m = static_cast<std::size_t>(maze_[i]);
+                const int width = maze_width_[m];
+                const int d = (heading_[i] + kTurn[o]) & 3;
+                const bool is_open = ((maps_[map_offset_[i] + cell[k]] >> d) & 1U) == 0;
+                const int step_to[4] = {width, 1, -width, -1};
+                const std::size_t next = is_open ? cell[k] + static_cast<std::size_t>(step_to[d]) : cell[k];
+                open[o][k] = is_open;
+                distance[o][k] = distances_[maze_offset_[m] + next];
+                visits[o][k] = visits_[map_offset_[i] + next];
+            }
+        }
+
+        // score and pick, branch-free over the arrays
+        for (std::size_t k = 0; k < active.size(); ++k) {
+            float best = -std::numeric_limits<float>::infinity();
+            std::uint8_t pick = kOptions;
+            for (int o = 0; o < kOptions; ++o) {
+                const float score = -(distance_weight[k] * distance[o][k] + visit_weight[k] * visits[o][k] +
+                                      turn_weight[k] * kTurnCost[o]);
+                const bool take = open[o][k] != 0 && score > best;
+                best = take ? score : best;
+                pick = take ? static_cast<std::uint8_t>(o) : pick;
+            }
+            choice[k] = pick;
+        }
+
+        // turn and move, then drop the mice that stopped
+        std::size_t kept = 0;
+        for (std::size_t k = 0; k < active.size(); ++k) {
+            const std::size_t i = active[k];
+            if (choice[k] == kOptions) {
+                state_[i] = State::STUCK;
+                continue;
+            }
+            const auto heading = static_cast<Direction>((heading_[i] + kTurn[choice[k]]) & 3);
+            heading_[i] = static_cast<std::uint8_t>(heading);
+            turns_[i] += kTurnCount[choice[k]];
+            x_[i] += dx(heading);
+            y_[i] += dy(heading);
+            ++moves_[i];
+            const auto m = static_cast<std::size_t>(maze_[i]);
+            const std::size_t here = static_cast<std::size_t>(y_[i] * maze_width_[m] + x_[i]);
+            std::uint16_t &entered = visits_[map_offset_[i] + here];
+            entered = static_cast<std::uint16_t>(entered + (entered != 0xFFFF ? 1 : 0));
+            if ((cells_[maze_offset_[m] + here] & kGoalBit) != 0) {
+                state_[i] = State::GOAL;
+                continue;
+            }
+            active[kept] = i;
+            distance_weight[kept] = distance_weight_[i];
+            visit_weight[kept] = visit_weight_[i];
+            turn_weight[kept] = turn_weight_[i];
+            ++kept;
+        }
+        active.resize(kept);
+    }
+}
@@ -0,0 +1,36 @@
+#include "mouse_controller.hpp"
+
+#include <stdexcept>
+
+micro_mouse::MouseController::MouseController(int width, int height, std::uint64_t max_moves)
+    : explorer_{width, height}, max_moves_{max_moves} {
+    explorer_.begin(max_moves_);
+    if (!explorer_.is_exploring()) {
+        next_phase();
+    }
+}
+
+void micro_mouse::MouseController::answer(const StepReply &reply) {
+    if (is_finished()) {
+        throw std::logic_error("the controller is finished");
+    }
+    explorer_.answer(reply);
+    if (!explorer_.is_exploring()) {
+        next_phase();
+    }
+}
+
+void micro_mouse::MouseController::next_phase() {
+    while (!explorer_.is_exploring() && !is_finished()) {
+        if (!explorer_.at_goal()) {
+            phase_ = Phase::FAILED;
+        } else if (phase_ == Phase::SEARCH) {
+            // the moves left are shared with the way back
+            phase_ = Phase::RETURN;
+            explorer_.set_goals({{0, 0}});
+            explorer_.begin(max_moves_ - explorer_.get_stats().moves);
+        } else {
+            phase_ = Phase::DONE;
+        }
+    }
+}
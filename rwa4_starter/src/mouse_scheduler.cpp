@@ -0,0 +1,35 @@
+#include "mouse_scheduler.hpp"
+
+int micro_mouse::MouseScheduler::add(MouseController &controller, MazeBackend &backend) {
+    mice_.push_back(Mouse{&controller, &backend});
+    if (!controller.is_finished()) {
+        running_.push_back(mice_.size() - 1);
+    }
+    return static_cast<int>(mice_.size()) - 1;
+}
+
+bool micro_mouse::MouseScheduler::run_round() {
+    if (running_.empty()) {
+        return false;
+    }
+    for (const std::size_t i : running_) {
+        mice_[i].backend->post_step(mice_[i].controller->get_command());
+    }
+    std::size_t kept = 0;
+    for (const std::size_t i : running_) {
+        MouseController &controller = *mice_[i].controller;
+        controller.answer(mice_[i].backend->wait_step());
+        ++steps_;
+        if (!controller.is_finished()) {
+            running_[kept++] = i;
+        }
+    }
+    running_.resize(kept);
+    ++rounds_;
+    return !running_.empty();
+}
+
+void micro_mouse::MouseScheduler::run() {
+    while (run_round()) {
+    }
+}
@@ -0,0 +1,14 @@
+#include "path.hpp"
+
+micro_mouse::Segment micro_mouse::turn_between(Direction from, Direction to) noexcept {
+    switch ((static_cast<int>(to) - static_cast<int>(from)) & 3) {
+    case 1:
+        return {Segment::Kind::TURN_RIGHT, 0};
+    case 2:
+        return {Segment::Kind::TURN_AROUND, 0};
+    case 3:
+        return {Segment::Kind::TURN_LEFT, 0};
+    default:
+        return {Segment::Kind::FORWARD, 0};
+    }
+}
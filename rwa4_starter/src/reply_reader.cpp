@@ -0,0 +1,85 @@
+#include "reply_reader.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "api_instrumentation.hpp"
+
+namespace {
+
+bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+} // namespace
+
+bool micro_mouse::ReplyReader::fill() {
+    if (begin_ > 0) {
+        // keep a token split across two reads contiguous
+        std::memmove(buffer_, buffer_ + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+    if (end_ == kCapacity) {
+        // a single token filling the buffer: hand it out truncated
+        return false;
+    }
+    ssize_t count;
+    do {
+        count = ::read(fd_, buffer_ + end_, kCapacity - end_);
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) {
+        return false;
+    }
+    end_ += static_cast<std::size_t>(count);
+    instrument_bytes_read(static_cast<std::size_t>(count));
+    return true;
+}
+
+std::string_view micro_mouse::ReplyReader::next_token() {
+    // skip leading whitespace
+    while (true) {
+        while (begin_ < end_ && is_space(buffer_[begin_])) {
+            ++begin_;
+        }
+        if (begin_ < end_ || !fill()) {
+            break;
+        }
+    }
+    // the token ends at the next whitespace, possibly after more reads
+    std::size_t scanned = begin_;
+    while (true) {
+        while (scanned < end_ && !is_space(buffer_[scanned])) {
+            ++scanned;
+        }
+        if (scanned < end_) {
+            break;
+        }
+        const std::size_t offset = scanned - begin_;
+        if (!fill()) {
+            scanned = end_;
+            break;
+        }
+        scanned = begin_ + offset;
+    }
+    const std::string_view token(buffer_ + begin_, scanned - begin_);
+    begin_ = scanned;
+    return token;
+}
+
+int micro_mouse::ReplyReader::read_int() {
+    const std::string_view token = next_token();
+    std::size_t i = 0;
+    bool negative = false;
+    if (i < token.size() && (token[i] == '-' || token[i] == '+')) {
+        negative = token[i] == '-';
+        ++i;
+    }
+    int value = 0;
+    for (; i < token.size() && token[i] >= '0' && token[i] <= '9'; ++i) {
+        value = value * 10 + (token[i] - '0');
+    }
+    return negative ? -value : value;
+}
@@ -0,0 +1,222 @@
+#include "maze_backend.hpp"
+
+#include <charconv>
+#include <iostream>
+#include <stdexcept>
+
+#include "api_instrumentation.hpp"
+
+namespace {
+
+void append(std::string &out, std::string_view text) {
+    out.append(text);
+}
+
+void append(std::string &out, char c) {
+    out.push_back(c);
+}
+
+void append(std::string &out, int value) {
+    char digits[16];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+} // namespace
+
+micro_mouse::TextPipeBackend::~TextPipeBackend() {
+    flush();
+}
+
+template <typename... Args>
+void micro_mouse::TextPipeBackend::write_command(std::string_view command, const Args &...args) {
+    append(pending_, command);
+    ((append(pending_, ' '), append(pending_, args)), ...);
+    pending_.push_back('\n');
+}
+
+void micro_mouse::TextPipeBackend::write_move(int distance) {
+    // Don't print distance argument unless explicitly specified, for
+    // backwards compatibility with older versions of the simulator
+    if (distance != 1) {
+        write_command("moveForward", distance);
+    } else {
+        write_command("moveForward ");
+    }
+}
+
+template <typename... Args>
+void micro_mouse::TextPipeBackend::queue(std::string_view command, const Args &...args) {
+    write_command(command, args...);
+    if (!buffered_) {
+        flush();
+    }
+}
+
+template <typename... Args>
+void micro_mouse::TextPipeBackend::send_request(std::string_view command, const Args &...args) {
+    write_command(command, args...);
+    flush();
+}
+
+void micro_mouse::TextPipeBackend::flush() {
+    if (!pending_.empty()) {
+        instrument_bytes_written(pending_.size());
+        std::cout.write(pending_.data(), static_cast<std::streamsize>(pending_.size()));
+        pending_.clear();
+    }
+    std::cout.flush();
+}
+
+int micro_mouse::TextPipeBackend::get_maze_width() {
+    send_request("mazeWidth");
+    return reader_.read_int();
+}
+
+int micro_mouse::TextPipeBackend::get_maze_height() {
+    send_request("mazeHeight");
+    return reader_.read_int();
+}
+
+bool micro_mouse::TextPipeBackend::has_wall_front() {
+    send_request("wallFront");
+    return reader_.read_bool();
+}
+
+bool micro_mouse::TextPipeBackend::has_wall_right() {
+    send_request("wallRight");
+    return reader_.read_bool();
+}
+
+bool micro_mouse::TextPipeBackend::has_wall_left() {
+    send_request("wallLeft");
+    return reader_.read_bool();
+}
+
+void micro_mouse::TextPipeBackend::move_forward(int distance) {
+    write_move(distance);
+    flush();
+    const std::string_view response = reader_.next_token();
+    if (response != "ack") {
+        std::cerr << response << std::endl;
+        throw std::runtime_error(std::string(response));
+    }
+}
+
+void micro_mouse::TextPipeBackend::turn_right() {
+    send_request("turnRight");
+    reader_.next_token();
+}
+
+void micro_mouse::TextPipeBackend::turn_left() {
+    send_request("turnLeft");
+    reader_.next_token();
+}
+
+void micro_mouse::TextPipeBackend::set_wall(int x, int y, char direction) {
+    queue("setWall", x, y, direction);
+}
+
+void micro_mouse::TextPipeBackend::clear_wall(int x, int y, char direction) {
+    queue("clearWall", x, y, direction);
+}
+
+void micro_mouse::TextPipeBackend::set_color(int x, int y, char color) {
+    queue("setColor", x, y, color);
+}
+
+void micro_mouse::TextPipeBackend::clear_color(int x, int y) {
+    queue("clearColor", x, y);
+}
+
+void micro_mouse::TextPipeBackend::clear_all_color() {
+    queue("clearAllColor");
+}
+
+void micro_mouse::TextPipeBackend::set_text(int x, int y, const std::string& text) {
+    queue("setText", x, y, std::string_view(text));
+}
+
+void micro_mouse::TextPipeBackend::clear_text(int x, int y) {
+    queue("clearText", x, y);
+}
+
+void micro_mouse::TextPipeBackend::clear_all_text() {
+    queue("clearAllText");
+}
+
+bool micro_mouse::TextPipeBackend::was_reset() {
+    send_request("wasReset");
+    return reader_.read_bool();
+}
+
+void micro_mouse::TextPipeBackend::ack_reset() {
+    send_request("ackReset");
+    reader_.next_token();
+}
+
+void micro_mouse::TextPipeBackend::post_step(const StepCommand &step) {
+    MazeBackend::post_step(step);
+    switch (step.turns & 3) {
+    case 1:
+        write_command("turnRight");
+        break;
+    case 2:
+        write_command("turnRight");
+        write_command("turnRight");
+        break;
+    case 3:
+        write_command("turnLeft");
+        break;
+    default:
+        break;
+    }
+    if (step.distance != 0) {
+        write_move(step.distance);
+    }
+    if (step.check_reset) {
+        write_command("wasReset");
+    }
+    if (step.sense & 1U) {
+        write_command("wallLeft");
+    }
+    if (step.sense & 2U) {
+        write_command("wallFront");
+    }
+    if (step.sense & 4U) {
+        write_command("wallRight");
+    }
+    flush();
+}
+
+micro_mouse::StepReply micro_mouse::TextPipeBackend::wait_step() {
+    const StepCommand step = take_step();
+    // a left turn is one command, like a right turn
+    const int turns = step.turns & 3;
+    for (int turn = turns == 3 ? 1 : turns; turn > 0; --turn) {
+        reader_.next_token();
+    }
+    // the view dies with the next read, and the queries after a failed move
+    // still have to be read
+    const std::string_view response = step.distance != 0 ? reader_.next_token() : std::string_view("ack");
+    const bool moved = response == "ack";
+    const std::string error = moved ? std::string() : std::string(response);
+    StepReply reply;
+    if (step.check_reset) {
+        reply.reset = reader_.read_bool();
+    }
+    if (step.sense & 1U) {
+        reply.wall_left = reader_.read_bool();
+    }
+    if (step.sense & 2U) {
+        reply.wall_front = reader_.read_bool();
+    }
+    if (step.sense & 4U) {
+        reply.wall_right = reader_.read_bool();
+    }
+    if (!moved) {
+        std::cerr << error << std::endl;
+        throw std::runtime_error(error);
+    }
+    return reply;
+}
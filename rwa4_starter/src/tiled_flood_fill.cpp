@@ -0,0 +1,408 @@
+#include "tiled_flood_fill.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Runs the jobs of one compute() on a fixed set of threads, the calling
+// thread included. Between jobs the workers poll a generation counter and
+// yield the CPU while they wait.
+class Gang {
+public:
+    explicit Gang(unsigned threads) {
+        for (unsigned t = 1; t < threads; ++t) {
+            workers_.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~Gang() {
+        stop_.store(true, std::memory_order_release);
+        for (auto &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    Gang(const Gang &) = delete;
+    Gang &operator=(const Gang &) = delete;
+
+    // Call job(i) for every i < count and wait until all calls returned
+    template <typename Job>
+    void run(std::size_t count, Job &job) {
+        if (workers_.empty() || count < 2) {
+            for (std::size_t i = 0; i < count; ++i) {
+                job(i);
+            }
+            return;
+        }
+        call_ = [](void *context, std::size_t i) { (*static_cast<Job *>(context))(i); };
+        context_ = &job;
+        count_ = count;
+        next_.store(0, std::memory_order_relaxed);
+        busy_.store(static_cast<unsigned>(workers_.size()), std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_release);
+        pull();
+        while (busy_.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    void pull() {
+        for (std::size_t i = next_.fetch_add(1, std::memory_order_relaxed); i < count_;
+             i = next_.fetch_add(1, std::memory_order_relaxed)) {
+            call_(context_, i);
+        }
+    }
+
+    void work() {
+        std::uint64_t seen = 0;
+        for (;;) {
+            std::uint64_t generation = generation_.load(std::memory_order_acquire);
+            while (generation == seen) {
+                if (stop_.load(std::memory_order_acquire)) {
+                    return;
+                }
+                std::this_thread::yield();
+                generation = generation_.load(std::memory_order_acquire);
+            }
+            seen = generation;
+            pull();
+            busy_.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    void (*call_)(void *, std::size_t){nullptr};
+    void *context_{nullptr};
+    std::size_t count_{0};
+    std::atomic<std::size_t> next_{0};
+    std::atomic<unsigned> busy_{0};
+    std::atomic<std::uint64_t> generation_{0};
+    std::atomic<bool> stop_{false};
+};
+
+bool test(const std::uint64_t *plane, int cell) {
+    return (plane[cell >> 6] >> (cell & 63)) & 1U;
+}
+
+} // namespace
+
+micro_mouse::TiledFloodFillPlanner::TiledFloodFillPlanner(int tile_size, unsigned threads)
+    : tile_{tile_size}, shift_{0}, window_{static_cast<std::uint32_t>(tile_size)} {
+    if (tile_size < 8 || tile_size > 256 || (tile_size & (tile_size - 1)) != 0) {
+        throw std::invalid_argument("tile size must be a power of two from 8 to 256");
+    }
+    while ((1 << shift_) < tile_size) {
+        ++shift_;
+    }
+    set_threads(threads);
+}
+
+void micro_mouse::TiledFloodFillPlanner::set_threads(unsigned threads) noexcept {
+    threads_ = threads != 0 ? threads : std::max(1U, std::thread::hardware_concurrency());
+}
+
+int micro_mouse::TiledFloodFillPlanner::edge_cell(Direction side, int k) const noexcept {
+    switch (side) {
+    case Direction::NORTH:
+        return ((tile_ - 1) << shift_) + k;
+    case Direction::EAST:
+        return (k << shift_) + tile_ - 1;
+    case Direction::SOUTH:
+        return k;
+    case Direction::WEST:
+        return k << shift_;
+    }
+    return 0;
+}
+
+int micro_mouse::TiledFloodFillPlanner::neighbour_tile(int tile, Direction side) const noexcept {
+    const int tx = tile % tiles_x_;
+    const int ty = tile / tiles_x_;
+    switch (side) {
+    case Direction::NORTH:
+        return ty + 1 < tiles_y_ ? tile + tiles_x_ : -1;
+    case Direction::EAST:
+        return tx + 1 < tiles_x_ ? tile + 1 : -1;
+    case Direction::SOUTH:
+        return ty > 0 ? tile - tiles_x_ : -1;
+    case Direction::WEST:
+        return tx > 0 ? tile - 1 : -1;
+    }
+    return -1;
+}
+
+void micro_mouse::TiledFloodFillPlanner::build_tile(const MazeMap &map, int tile) {
+    const std::size_t base = static_cast<std::size_t>(tile) << (2 * shift_);
+    const std::size_t area = std::size_t{1} << (2 * shift_);
+    std::fill_n(distances_.begin() + static_cast<std::ptrdiff_t>(base), area, kUnreachable);
+    std::fill_n(open_.begin() + static_cast<std::ptrdiff_t>(base), area, std::uint8_t{0});
+    std::fill_n(edges_.begin() + static_cast<std::ptrdiff_t>(4 * static_cast<std::size_t>(tile) * tile_), 4 * tile_,
+                kUnreachable);
+    seeds_[static_cast<std::size_t>(tile)].clear();
+
+    const std::uint64_t *east_present = map.get_plane(MazeMap::Plane::EAST_PRESENT);
+    const std::uint64_t *east_known = map.get_plane(MazeMap::Plane::EAST_KNOWN);
+    const std::uint64_t *north_present = map.get_plane(MazeMap::Plane::NORTH_PRESENT);
+    const std::uint64_t *north_known = map.get_plane(MazeMap::Plane::NORTH_KNOWN);
+    const bool known_only = policy_ == FloodFillBase::WallPolicy::KNOWN_ONLY;
+    auto open_east = [&](int cell) { return !test(east_present, cell) && (!known_only || test(east_known, cell)); };
+    auto open_north = [&](int cell) { return !test(north_present, cell) && (!known_only || test(north_known, cell)); };
+
+    // boundary walls are always present, so cells on the maze edge and the
+    // padding past it stay closed towards the outside
+    const int x0 = (tile % tiles_x_) << shift_;
+    const int y0 = (tile / tiles_x_) << shift_;
+    for (int ly = 0; ly < tile_ && y0 + ly < height_; ++ly) {
+        for (int lx = 0; lx < tile_ && x0 + lx < width_; ++lx) {
+            const int x = x0 + lx;
+            const int y = y0 + ly;
+            const int cell = y * width_ + x;
+            unsigned open = 0;
+            open |= static_cast<unsigned>(open_north(cell)) << static_cast<int>(Direction::NORTH);
+            open |= static_cast<unsigned>(open_east(cell)) << static_cast<int>(Direction::EAST);
+            open |= static_cast<unsigned>(y > 0 && open_north(cell - width_)) << static_cast<int>(Direction::SOUTH);
+            open |= static_cast<unsigned>(x > 0 && open_east(cell - 1)) << static_cast<int>(Direction::WEST);
+            unsigned inside = 0;
+            inside |= static_cast<unsigned>(ly + 1 < tile_) << static_cast<int>(Direction::NORTH);
+            inside |= static_cast<unsigned>(lx + 1 < tile_) << static_cast<int>(Direction::EAST);
+            inside |= static_cast<unsigned>(ly > 0) << static_cast<int>(Direction::SOUTH);
+            inside |= static_cast<unsigned>(lx > 0) << static_cast<int>(Direction::WEST);
+            open_[base + static_cast<std::size_t>((ly << shift_) + lx)] = static_cast<std::uint8_t>(open | (open & inside) << 4);
+        }
+    }
+}
+
+std::uint64_t micro_mouse::TiledFloodFillPlanner::relax_tile(int tile) {
+    // The seeds carry different distances. Sorted, they come in increasing
+    // distance like the FIFO does, so always taking the smaller of the two
+    // heads settles the cells in distance order: an exact BFS.
+    thread_local std::vector<std::uint32_t> queue;
+    std::vector<Seed> &seeds = seeds_[static_cast<std::size_t>(tile)];
+    std::sort(seeds.begin(), seeds.end(), [](const Seed &a, const Seed &b) { return a.distance < b.distance; });
+    const std::size_t base = static_cast<std::size_t>(tile) << (2 * shift_);
+    std::uint32_t *distance = distances_.data() + base;
+    const std::uint8_t *open = open_.data() + base;
+    const int offsets[] = {tile_, 1, -tile_, -1};
+
+    queue.clear();
+    std::size_t head = 0;
+    std::size_t next_seed = 0;
+    std::uint64_t expanded = 0;
+    while (head < queue.size() || next_seed < seeds.size()) {
+        std::uint32_t cell = 0;
+        if (next_seed == seeds.size() ||
+            (head < queue.size() && distance[queue[head]] <= seeds[next_seed].distance)) {
+            cell = queue[head++];
+        } else {
+            const Seed &seed = seeds[next_seed++];
+            if (seed.distance != distance[seed.cell]) {
+                continue; // improved again by a later exchange
+            }
+            cell = seed.cell;
+        }
+        const std::uint32_t next = distance[cell] + 1;
+        const unsigned inside = open[cell] >> 4;
+        for (int d = 0; d < 4; ++d) {
+            if ((inside >> d) & 1U) {
+                const auto neighbour = static_cast<std::uint32_t>(static_cast<int>(cell) + offsets[d]);
+                if (next < distance[neighbour]) {
+                    distance[neighbour] = next;
+                    queue.push_back(neighbour);
+                }
+            }
+        }
+        ++expanded;
+    }
+    seeds.clear();
+    lowest_seed_[static_cast<std::size_t>(tile)] = kUnreachable;
+
+    // publish the edges for the neighbours
+    std::uint32_t *edges = edges_.data() + 4 * static_cast<std::size_t>(tile) * tile_;
+    unsigned changed = 0;
+    for (int d = 0; d < 4; ++d) {
+        for (int k = 0; k < tile_; ++k) {
+            const std::uint32_t value = distance[edge_cell(static_cast<Direction>(d), k)];
+            std::uint32_t &published = edges[d * tile_ + k];
+            if (value != published) {
+                published = value;
+                changed |= 1U << d;
+            }
+        }
+    }
+    changed_[static_cast<std::size_t>(tile)] = static_cast<std::uint8_t>(changed);
+    return expanded;
+}
+
+bool micro_mouse::TiledFloodFillPlanner::exchange_tile(int tile) {
+    const std::size_t base = static_cast<std::size_t>(tile) << (2 * shift_);
+    std::uint32_t *distance = distances_.data() + base;
+    const std::uint8_t *open = open_.data() + base;
+    std::vector<Seed> &seeds = seeds_[static_cast<std::size_t>(tile)];
+    std::uint32_t &lowest = lowest_seed_[static_cast<std::size_t>(tile)];
+    for (int d = 0; d < 4; ++d) {
+        const auto side = static_cast<Direction>(d);
+        const int other = neighbour_tile(tile, side);
+        const auto facing = static_cast<int>(opposite(side));
+        if (other < 0 || ((changed_[static_cast<std::size_t>(other)] >> facing) & 1U) == 0) {
+            continue;
+        }
+        const std::uint32_t *theirs = edges_.data() + 4 * static_cast<std::size_t>(other) * tile_ +
+                                      static_cast<std::size_t>(facing * tile_);
+        for (int k = 0; k < tile_; ++k) {
+            const int cell = edge_cell(side, k);
+            if (((open[cell] >> d) & 1U) == 0 || theirs[k] == kUnreachable) {
+                continue;
+            }
+            const std::uint32_t candidate = theirs[k] + 1;
+            if (candidate < distance[cell]) {
+                distance[cell] = candidate;
+                seeds.push_back({candidate, static_cast<std::uint32_t>(cell)});
+                lowest = std::min(lowest, candidate);
+            }
+        }
+    }
+    return !seeds.empty();
+}
+
+void micro_mouse::TiledFloodFillPlanner::compute(const MazeMap &map, const std::vector<Cell> &goals) {
+    width_ = map.get_width();
+    height_ = map.get_height();
+    tiles_x_ = (width_ + tile_ - 1) >> shift_;
+    tiles_y_ = (height_ + tile_ - 1) >> shift_;
+    const int tiles = tiles_x_ * tiles_y_;
+    const std::size_t cells = static_cast<std::size_t>(tiles) << (2 * shift_);
+    distances_.resize(cells);
+    open_.resize(cells);
+    edges_.resize(4 * static_cast<std::size_t>(tiles) * tile_);
+    changed_.assign(static_cast<std::size_t>(tiles), 0);
+    seeds_.resize(static_cast<std::size_t>(tiles));
+    lowest_seed_.assign(static_cast<std::size_t>(tiles), kUnreachable);
+    listed_.assign(static_cast<std::size_t>(tiles), 0);
+    stamps_.assign(static_cast<std::size_t>(tiles), 0);
+    stats_ = Stats{};
+    unpacked_ = false;
+
+    Gang gang(std::min(threads_, static_cast<unsigned>(tiles)));
+    auto build = [this, &map](std::size_t tile) { build_tile(map, static_cast<int>(tile)); };
+    gang.run(static_cast<std::size_t>(tiles), build);
+
+    // tiles holding seeds, each listed once
+    std::vector<int> pending;
+    for (const auto &goal : goals) {
+        if (!map.contains(goal.x, goal.y)) {
+            continue;
+        }
+        const std::size_t index = storage_index(goal.x, goal.y);
+        const auto tile = static_cast<int>(index >> (2 * shift_));
+        if (distances_[index] != 0) {
+            distances_[index] = 0;
+            if (listed_[static_cast<std::size_t>(tile)] == 0) {
+                listed_[static_cast<std::size_t>(tile)] = 1;
+                pending.push_back(tile);
+            }
+            seeds_[static_cast<std::size_t>(tile)].push_back(
+                {0, static_cast<std::uint32_t>(index & ((std::size_t{1} << (2 * shift_)) - 1))});
+            lowest_seed_[static_cast<std::size_t>(tile)] = 0;
+        }
+    }
+
+    std::atomic<std::uint64_t> expanded{0};
+    std::vector<int> dirty;
+    std::vector<int> waiting;
+    std::vector<int> candidates;
+    std::vector<std::uint8_t> pulled;
+    auto relax = [this, &dirty, &expanded](std::size_t i) {
+        expanded.fetch_add(relax_tile(dirty[i]), std::memory_order_relaxed);
+    };
+    auto exchange = [this, &candidates, &pulled](std::size_t i) {
+        pulled[i] = exchange_tile(candidates[i]) ? 1 : 0;
+    };
+    while (!pending.empty()) {
+        ++stats_.rounds;
+        // Only the tiles whose seeds are within a window of the lowest seed
+        // run, as in delta-stepping: a tile far ahead of the wavefront would
+        // likely be improved again once the front reaches it by a shorter way
+        std::uint32_t lowest = kUnreachable;
+        for (const int tile : pending) {
+            lowest = std::min(lowest, lowest_seed_[static_cast<std::size_t>(tile)]);
+        }
+        const std::uint32_t limit = lowest + std::min<std::uint32_t>(window_, kUnreachable - lowest);
+        dirty.clear();
+        waiting.clear();
+        for (const int tile : pending) {
+            if (lowest_seed_[static_cast<std::size_t>(tile)] <= limit) {
+                listed_[static_cast<std::size_t>(tile)] = 0;
+                dirty.push_back(tile);
+            } else {
+                waiting.push_back(tile);
+            }
+        }
+        gang.run(dirty.size(), relax);
+        stats_.tile_passes += dirty.size();
+
+        // the neighbours of every changed edge pull from it
+        candidates.clear();
+        for (const int tile : dirty) {
+            for (int d = 0; d < 4; ++d) {
+                const int other = neighbour_tile(tile, static_cast<Direction>(d));
+                if (((changed_[static_cast<std::size_t>(tile)] >> d) & 1U) != 0 && other >= 0 &&
+                    stamps_[static_cast<std::size_t>(other)] != stats_.rounds) {
+                    stamps_[static_cast<std::size_t>(other)] = stats_.rounds;
+                    candidates.push_back(other);
+                }
+            }
+        }
+        pulled.assign(candidates.size(), 0);
+        gang.run(candidates.size(), exchange);
+
+        for (const int tile : dirty) {
+            changed_[static_cast<std::size_t>(tile)] = 0;
+        }
+        pending.swap(waiting);
+        for (std::size_t i = 0; i < candidates.size(); ++i) {
+            if (pulled[i] != 0 && listed_[static_cast<std::size_t>(candidates[i])] == 0) {
+                listed_[static_cast<std::size_t>(candidates[i])] = 1;
+                pending.push_back(candidates[i]);
+            }
+        }
+    }
+    stats_.expansions = expanded.load(std::memory_order_relaxed);
+}
+
+const std::vector<std::uint32_t> &micro_mouse::TiledFloodFillPlanner::get_distances() const {
+    if (!unpacked_) {
+        row_major_.resize(static_cast<std::size_t>(width_) * static_cast<std::size_t>(height_));
+        for (int y = 0; y < height_; ++y) {
+            for (int x = 0; x < width_; ++x) {
+                row_major_[static_cast<std::size_t>(y) * static_cast<std::size_t>(width_) + static_cast<std::size_t>(x)] =
+                    get_distance(x, y);
+            }
+        }
+        unpacked_ = true;
+    }
+    return row_major_;
+}
+
+bool micro_mouse::TiledFloodFillPlanner::next_direction(const Pose &pose, Direction &direction) const noexcept {
+    std::uint32_t best = get_distance(pose.x, pose.y);
+    const unsigned open = open_[storage_index(pose.x, pose.y)];
+    bool found = false;
+    // current heading first, so that it wins ties
+    const Direction candidates[] = {pose.heading, turn_left(pose.heading), turn_right(pose.heading), opposite(pose.heading)};
+    for (const auto candidate : candidates) {
+        if (((open >> static_cast<int>(candidate)) & 1U) == 0) {
+            continue;
+        }
+        const std::uint32_t distance = get_distance(pose.x + dx(candidate), pose.y + dy(candidate));
+        if (distance < best) {
+            best = distance;
+            direction = candidate;
+            found = true;
+        }
+    }
+    return found;
+}
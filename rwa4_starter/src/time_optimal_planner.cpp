@@ -0,0 +1,44 @@
+#include "time_optimal_planner.hpp"
+
+#include <cmath>
+
+micro_mouse::TimeOptimalPlanner::TimeOptimalPlanner(const RunCostModel &model) : model_{model} {
+    grow_table(16);
+}
+
+void micro_mouse::TimeOptimalPlanner::grow_table(int cells) {
+    // rest to rest: accelerate to max_speed if the straight is long enough,
+    // otherwise a triangular profile peaking half way
+    const double ramp = model_.max_speed * model_.max_speed / model_.acceleration;
+    for (int n = static_cast<int>(straight_times_.size()); n <= cells; ++n) {
+        const double distance = n * model_.cell_length;
+        straight_times_.push_back(distance >= ramp ? distance / model_.max_speed + model_.max_speed / model_.acceleration
+                                                   : 2.0 * std::sqrt(distance / model_.acceleration));
+    }
+}
+
+double micro_mouse::TimeOptimalPlanner::straight_time(int cells) {
+    if (cells >= static_cast<int>(straight_times_.size())) {
+        grow_table(cells);
+    }
+    return straight_times_[static_cast<std::size_t>(cells)];
+}
+
+double micro_mouse::TimeOptimalPlanner::estimate(const std::vector<Segment> &segments) {
+    double time = 0.0;
+    for (const auto &segment : segments) {
+        switch (segment.kind) {
+        case Segment::Kind::FORWARD:
+            time += straight_time(segment.cells);
+            break;
+        case Segment::Kind::TURN_LEFT:
+        case Segment::Kind::TURN_RIGHT:
+            time += model_.turn_time;
+            break;
+        case Segment::Kind::TURN_AROUND:
+            time += model_.turn_around_time;
+            break;
+        }
+    }
+    return time;
+}
@@ -0,0 +1,301 @@
+// Tunes exploration heuristics by running many mice at once, one per maze and
+// heuristic, in a MouseBatch.
+//
+// Usage: batch_explore [--threads N] [--weights D,V,T[;D,V,T...]] [--max-steps N]
+//                      [--corpus FILE] [--generate N] [--size WxH] [--seed S]
+//                      [--verify] [<maze-file-or-directory>...]
+//
+// --weights lists the heuristics to compare, as weights of the distance to
+// the center, the visit count and the turns (see MouseBatch::Heuristic).
+// --generate adds N random mazes of --size from MazeGenerator. Prints one CSV
+// line per heuristic with the share of mice reaching the center and the
+// means over them. --verify replays every mouse alone through MazeControlAPI
+// and the direct backend and checks that it ends with the same moves, turns
+// and pose.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "direct_backend.hpp"
+#include "maze_api.hpp"
+#include "maze_corpus.hpp"
+#include "maze_generator.hpp"
+#include "maze_simulator.hpp"
+#include "mouse_batch.hpp"
+
+namespace {
+
+using micro_mouse::MouseBatch;
+
+struct Run {
+    MouseBatch::State state{MouseBatch::State::RUNNING};
+    micro_mouse::Pose pose{};
+    std::uint32_t moves{0};
+    std::uint32_t turns{0};
+};
+
+// One mouse through MazeControlAPI, deciding like MouseBatch, one command at
+// a time
+Run reference(micro_mouse::MazeSimulator maze, const MouseBatch::Heuristic &heuristic, std::uint64_t max_steps) {
+    using micro_mouse::Direction;
+    using micro_mouse::MazeControlAPI;
+    micro_mouse::DirectBackend backend(maze);
+    MazeControlAPI::set_backend(&backend);
+    const int width = maze.get_width();
+    const int height = maze.get_height();
+    const auto index = [width](int x, int y) { return static_cast<std::size_t>(y * width + x); };
+    std::vector<unsigned> walls(static_cast<std::size_t>(width * height), 0);
+    std::vector<std::uint16_t> visits(walls.size(), 0);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            walls[index(x, y)] = (y == height - 1 ? 1U : 0U) | (x == width - 1 ? 2U : 0U) | (y == 0 ? 4U : 0U) |
+                                 (x == 0 ? 8U : 0U);
+        }
+    }
+    const auto distance = [&](int x, int y) {
+        int best = std::numeric_limits<int>::max();
+        for (const int gx : {(width - 1) / 2, width / 2}) {
+            for (const int gy : {(height - 1) / 2, height / 2}) {
+                best = std::min(best, std::abs(x - gx) + std::abs(y - gy));
+            }
+        }
+        return static_cast<float>(best);
+    };
+
+    Run run;
+    run.pose = {0, 0, Direction::NORTH};
+    visits[index(0, 0)] = 1;
+    constexpr int kTurn[] = {0, 3, 1, 2};
+    constexpr float kTurnCost[] = {0.0f, 1.0f, 1.0f, 2.0f};
+    for (std::uint64_t step = 0; step < max_steps; ++step) {
+        if (maze.is_goal(run.pose.x, run.pose.y)) {
+            run.state = MouseBatch::State::GOAL;
+            break;
+        }
+        const auto side = [&](int turn) { return (static_cast<int>(run.pose.heading) + turn) & 3; };
+        unsigned &here = walls[index(run.pose.x, run.pose.y)];
+        here |= MazeControlAPI::has_wall_left() ? 1U << side(3) : 0U;
+        here |= MazeControlAPI::has_wall_front() ? 1U << side(0) : 0U;
+        here |= MazeControlAPI::has_wall_right() ? 1U << side(1) : 0U;
+
+        float best = -std::numeric_limits<float>::infinity();
+        int pick = -1;
+        for (int o = 0; o < 4; ++o) {
+            const auto d = static_cast<Direction>(side(kTurn[o]));
+            if ((here >> static_cast<int>(d) & 1U) != 0) {
+                continue;
+            }
+            const int x = run.pose.x + micro_mouse::dx(d);
+            const int y = run.pose.y + micro_mouse::dy(d);
+            const float score = -(heuristic.distance * distance(x, y) +
+                                  heuristic.visits * static_cast<float>(visits[index(x, y)]) +
+                                  heuristic.turns * kTurnCost[o]);
+            if (score > best) {
+                best = score;
+                pick = o;
+            }
+        }
+        if (pick < 0) {
+            run.state = MouseBatch::State::STUCK;
+            break;
+        }
+        if (pick == 1) {
+            MazeControlAPI::turn_left();
+        } else if (pick >= 2) {
+            for (int turn = 0; turn < pick - 1; ++turn) {
+                MazeControlAPI::turn_right();
+            }
+        }
+        run.turns += pick == 3 ? 2 : pick != 0 ? 1 : 0;
+        run.pose.heading = static_cast<Direction>(side(kTurn[pick]));
+        MazeControlAPI::move_forward();
+        run.pose.x += micro_mouse::dx(run.pose.heading);
+        run.pose.y += micro_mouse::dy(run.pose.heading);
+        ++run.moves;
+        std::uint16_t &entered = visits[index(run.pose.x, run.pose.y)];
+        entered = static_cast<std::uint16_t>(entered + (entered != 0xFFFF ? 1 : 0));
+    }
+    if (run.state == MouseBatch::State::RUNNING && maze.is_goal(run.pose.x, run.pose.y)) {
+        run.state = MouseBatch::State::GOAL;
+    }
+    MazeControlAPI::set_backend(nullptr);
+    return run;
+}
+
+bool parse_weights(const std::string &text, std::vector<MouseBatch::Heuristic> &heuristics) {
+    std::istringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ';')) {
+        MouseBatch::Heuristic heuristic;
+        char comma1 = 0;
+        char comma2 = 0;
+        std::istringstream fields(item);
+        if (!(fields >> heuristic.distance >> comma1 >> heuristic.visits >> comma2 >> heuristic.turns) ||
+            comma1 != ',' || comma2 != ',') {
+            return false;
+        }
+        heuristics.push_back(heuristic);
+    }
+    return !heuristics.empty();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    unsigned threads = 0;
+    std::vector<MouseBatch::Heuristic> heuristics;
+    std::uint64_t max_steps = 0;
+    std::vector<std::string> files;
+    std::string corpus_path;
+    std::size_t generate = 0;
+    micro_mouse::MazeGenerator::Options options;
+    std::uint64_t seed = 1;
+    bool verify = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::max(1L, std::strtol(argv[++i], nullptr, 10)));
+        } else if (option == "--weights" && i + 1 < argc) {
+            if (!parse_weights(argv[++i], heuristics)) {
+                std::cerr << "bad --weights, expected D,V,T[;D,V,T...]" << std::endl;
+                return 1;
+            }
+        } else if (option == "--max-steps" && i + 1 < argc) {
+            max_steps = std::strtoull(argv[++i], nullptr, 10);
+        } else if (option == "--corpus" && i + 1 < argc) {
+            corpus_path = argv[++i];
+        } else if (option == "--generate" && i + 1 < argc) {
+            generate = std::strtoull(argv[++i], nullptr, 10);
+        } else if (option == "--size" && i + 1 < argc) {
+            const std::string size = argv[++i];
+            options.width = std::atoi(size.c_str());
+            const std::size_t x = size.find('x');
+            options.height = x == std::string::npos ? options.width : std::atoi(size.c_str() + x + 1);
+        } else if (option == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (option == "--verify") {
+            verify = true;
+        } else if (std::filesystem::is_directory(option)) {
+            std::vector<std::string> entries;
+            for (const auto &entry : std::filesystem::directory_iterator(option)) {
+                if (entry.is_regular_file()) {
+                    entries.push_back(entry.path().string());
+                }
+            }
+            // directory order is unspecified, keep the output reproducible
+            std::sort(entries.begin(), entries.end());
+            files.insert(files.end(), entries.begin(), entries.end());
+        } else {
+            files.push_back(option);
+        }
+    }
+    if (heuristics.empty()) {
+        heuristics.emplace_back();
+    }
+
+    std::vector<micro_mouse::MazeSimulator> mazes;
+    try {
+        for (const auto &file : files) {
+            mazes.push_back(micro_mouse::MazeSimulator::from_file(file));
+        }
+        if (!corpus_path.empty()) {
+            const micro_mouse::MazeCorpus corpus(corpus_path);
+            for (std::size_t i = 0; i < corpus.size(); ++i) {
+                mazes.push_back(corpus.load(i));
+            }
+        }
+        micro_mouse::MazeGenerator generator(seed);
+        for (std::size_t i = 0; i < generate; ++i) {
+            mazes.push_back(generator.generate(options));
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (mazes.empty()) {
+        std::cerr << "usage: batch_explore [--threads N] [--weights D,V,T[;D,V,T...]] [--max-steps N]\n"
+                     "                     [--corpus FILE] [--generate N] [--size WxH] [--seed S]\n"
+                     "                     [--verify] [<maze-file-or-directory>...]"
+                  << std::endl;
+        return 1;
+    }
+
+    // mouse h * mazes + m runs heuristic h in maze m
+    MouseBatch batch(threads);
+    std::uint64_t cells = 0;
+    for (const auto &maze : mazes) {
+        batch.add_maze(maze);
+        cells = std::max<std::uint64_t>(cells, static_cast<std::uint64_t>(maze.get_width() * maze.get_height()));
+    }
+    for (const auto &heuristic : heuristics) {
+        for (std::size_t m = 0; m < mazes.size(); ++m) {
+            batch.add_mouse(static_cast<int>(m), heuristic);
+        }
+    }
+    if (max_steps == 0) {
+        max_steps = 16 * cells;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    batch.run(max_steps);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::uint64_t steps = 0;
+    std::cout << "distance,visits,turns,mice,solved,mean_moves,mean_turns,mean_queries\n";
+    for (std::size_t h = 0; h < heuristics.size(); ++h) {
+        std::size_t solved = 0;
+        std::uint64_t moves = 0;
+        std::uint64_t turns = 0;
+        std::uint64_t queries = 0;
+        for (std::size_t m = 0; m < mazes.size(); ++m) {
+            const int mouse = static_cast<int>(h * mazes.size() + m);
+            steps += batch.get_moves(mouse);
+            if (batch.get_state(mouse) == MouseBatch::State::GOAL) {
+                ++solved;
+                moves += batch.get_moves(mouse);
+                turns += batch.get_turns(mouse);
+                queries += batch.get_wall_queries(mouse);
+            }
+        }
+        const double count = static_cast<double>(std::max<std::size_t>(solved, 1));
+        std::cout << heuristics[h].distance << ',' << heuristics[h].visits << ',' << heuristics[h].turns << ','
+                  << mazes.size() << ',' << solved << ',' << static_cast<double>(moves) / count << ','
+                  << static_cast<double>(turns) / count << ',' << static_cast<double>(queries) / count << '\n';
+    }
+    std::cout.flush();
+    std::cerr << batch.get_mouse_count() << " mice on " << batch.get_threads() << " threads: " << steps
+              << " steps in " << elapsed.count() << " s (" << static_cast<double>(steps) / elapsed.count()
+              << " steps/s)" << std::endl;
+
+    if (verify) {
+        std::size_t mismatches = 0;
+        for (std::size_t h = 0; h < heuristics.size(); ++h) {
+            for (std::size_t m = 0; m < mazes.size(); ++m) {
+                const int mouse = static_cast<int>(h * mazes.size() + m);
+                const Run run = reference(mazes[m], heuristics[h], max_steps);
+                const micro_mouse::Pose pose = batch.get_pose(mouse);
+                if (run.state != batch.get_state(mouse) || run.moves != batch.get_moves(mouse) ||
+                    run.turns != batch.get_turns(mouse) || run.pose.x != pose.x || run.pose.y != pose.y ||
+                    run.pose.heading != pose.heading) {
+                    std::cerr << "mouse " << mouse << " (maze " << m << ", heuristic " << h
+                              << ") differs from MazeControlAPI: " << batch.get_moves(mouse) << " moves against "
+                              << run.moves << std::endl;
+                    ++mismatches;
+                }
+            }
+        }
+        std::cerr << "verify: " << batch.get_mouse_count() - mismatches << '/' << batch.get_mouse_count()
+                  << " mice match" << std::endl;
+        if (mismatches != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,200 @@
+// Runs the explorer over a corpus of maze files on a pool of threads, each
+// maze against its own in-process simulator through the direct backend.
+//
+// Usage: corpus_bench [--threads N] [--corpus FILE] [--prune] [<maze-file-or-directory>...]
+//
+// --corpus reads the mazes of a binary corpus written by maze_pack instead of
+// parsing maze files. --prune skips dead ends while exploring, see
+// BasicExplorer::set_pruning().
+//
+// Every maze is explored from the start to the center and back, then run at
+// speed over the explored cells. Prints one CSV line per maze, in the order
+// of the arguments, then the totals and the means over the solved mazes.
+// The speed-run time is the estimate of the default RunCostModel;
+// flood_run_s is the estimate for the fewest-cells path over the same
+// explored cells, as compile_path() turns it into straights and turns.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "direct_backend.hpp"
+#include "explorer.hpp"
+#include "maze_api.hpp"
+#include "maze_corpus.hpp"
+#include "maze_simulator.hpp"
+#include "path.hpp"
+#include "time_optimal_planner.hpp"
+
+namespace {
+
+struct Result {
+    bool solved{false};
+    std::uint64_t steps{0};       // exploration moves, to the center and back
+    std::uint64_t turns{0};       // exploration turns
+    std::uint64_t commands{0};    // every command handled by the simulator
+    std::uint64_t plan_ns{0};
+    std::uint64_t speed_run_moves{0};
+    double speed_run_s{0.0};
+    double flood_run_s{0.0};      // fewest-cells path, same cost model
+    std::string error;
+};
+
+template <typename ExplorerType>
+void explore(const micro_mouse::MazeSimulator &maze, bool prune, Result &result) {
+    const std::uint64_t max_moves = 16ULL * static_cast<std::uint64_t>(maze.get_width() * maze.get_height());
+    ExplorerType explorer(maze.get_width(), maze.get_height());
+    explorer.set_pruning(prune);
+    const std::vector<micro_mouse::Cell> goals = explorer.get_goals();
+    if (explorer.explore(max_moves)) {
+        explorer.set_goals({{0, 0}});
+        explorer.explore(max_moves);
+        explorer.set_goals(goals);
+        // the cell-count path the time-optimal planner competes with
+        typename ExplorerType::Planner field;
+        field.set_wall_policy(micro_mouse::FloodFillBase::WallPolicy::KNOWN_ONLY);
+        field.compute(explorer.get_map(), goals);
+        micro_mouse::TimeOptimalPlanner model;
+        result.flood_run_s = model.estimate(micro_mouse::compile_path(explorer.get_map(), field, explorer.get_pose()));
+        result.steps = explorer.get_stats().moves;
+        result.turns = explorer.get_stats().turns;
+        result.solved = explorer.speed_run();
+        result.speed_run_moves = explorer.get_stats().moves - result.steps;
+        result.speed_run_s = explorer.get_runner().get_time();
+    } else {
+        result.steps = explorer.get_stats().moves;
+        result.turns = explorer.get_stats().turns;
+    }
+    result.plan_ns = explorer.get_stats().plan_ns;
+}
+
+template <typename Load>
+Result run(Load load, bool prune) {
+    Result result;
+    try {
+        micro_mouse::MazeSimulator maze = load();
+        micro_mouse::DirectBackend backend(maze);
+        micro_mouse::MazeControlAPI::set_backend(&backend);
+        if (maze.get_width() == micro_mouse::kClassicSize && maze.get_height() == micro_mouse::kClassicSize) {
+            explore<micro_mouse::ClassicExplorer>(maze, prune, result);
+        } else {
+            explore<micro_mouse::Explorer>(maze, prune, result);
+        }
+        result.commands = maze.get_stats().commands;
+    } catch (const std::exception &e) {
+        result.error = e.what();
+    }
+    micro_mouse::MazeControlAPI::set_backend(nullptr);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    unsigned threads = std::max(1U, std::thread::hardware_concurrency());
+    std::vector<std::string> files;
+    std::unique_ptr<micro_mouse::MazeCorpus> corpus;
+    bool prune = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::max(1L, std::strtol(argv[++i], nullptr, 10)));
+        } else if (option == "--corpus" && i + 1 < argc) {
+            try {
+                corpus = std::make_unique<micro_mouse::MazeCorpus>(argv[++i]);
+            } catch (const std::exception &e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        } else if (option == "--prune") {
+            prune = true;
+        } else if (std::filesystem::is_directory(option)) {
+            std::vector<std::string> entries;
+            for (const auto &entry : std::filesystem::directory_iterator(option)) {
+                if (entry.is_regular_file()) {
+                    entries.push_back(entry.path().string());
+                }
+            }
+            // directory order is unspecified, keep the output reproducible
+            std::sort(entries.begin(), entries.end());
+            files.insert(files.end(), entries.begin(), entries.end());
+        } else {
+            files.push_back(option);
+        }
+    }
+    // maze files first, then the mazes of the corpus
+    std::vector<std::string> names;
+    for (const auto &file : files) {
+        names.push_back(std::filesystem::path(file).filename().string());
+    }
+    for (std::size_t i = 0; corpus && i < corpus->size(); ++i) {
+        names.emplace_back(corpus->get_name(i));
+    }
+    if (names.empty()) {
+        std::cerr << "usage: corpus_bench [--threads N] [--corpus FILE] [--prune] [<maze-file-or-directory>...]" << std::endl;
+        return 1;
+    }
+
+    // each worker takes the next maze until none is left
+    std::vector<Result> results(names.size());
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for (std::size_t i = next++; i < names.size(); i = next++) {
+            results[i] = run([&]() {
+                return i < files.size() ? micro_mouse::MazeSimulator::from_file(files[i]) : corpus->load(i - files.size());
+            }, prune);
+        }
+    };
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    threads = std::min<unsigned>(threads, static_cast<unsigned>(names.size()));
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    Result total;
+    std::size_t solved = 0;
+    std::cout << "maze,solved,steps,turns,commands,plan_us,speed_run_moves,speed_run_s,flood_run_s\n";
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        const Result &result = results[i];
+        if (!result.error.empty()) {
+            std::cerr << names[i] << ": " << result.error << std::endl;
+        }
+        std::cout << names[i] << ',' << result.solved << ',' << result.steps
+                  << ',' << result.turns << ',' << result.commands << ',' << static_cast<double>(result.plan_ns) / 1e3
+                  << ',' << result.speed_run_moves << ',' << result.speed_run_s << ',' << result.flood_run_s << '\n';
+        if (result.solved) {
+            ++solved;
+            total.steps += result.steps;
+            total.turns += result.turns;
+            total.commands += result.commands;
+            total.plan_ns += result.plan_ns;
+            total.speed_run_moves += result.speed_run_moves;
+            total.speed_run_s += result.speed_run_s;
+            total.flood_run_s += result.flood_run_s;
+        }
+    }
+    const double count = static_cast<double>(std::max<std::size_t>(solved, 1));
+    std::cout << "TOTAL," << solved << ',' << total.steps << ',' << total.turns << ',' << total.commands << ','
+              << static_cast<double>(total.plan_ns) / 1e3 << ',' << total.speed_run_moves << ',' << total.speed_run_s
+              << ',' << total.flood_run_s << '\n'
+              << "MEAN," << static_cast<double>(solved) / static_cast<double>(names.size()) << ','
+              << static_cast<double>(total.steps) / count << ',' << static_cast<double>(total.turns) / count << ','
+              << static_cast<double>(total.commands) / count << ',' << static_cast<double>(total.plan_ns) / 1e3 / count
+              << ',' << static_cast<double>(total.speed_run_moves) / count << ',' << total.speed_run_s / count
+              << ',' << total.flood_run_s / count << std::endl;
+    std::cerr << names.size() << " mazes on " << threads << " threads in " << elapsed.count() << " s ("
+              << static_cast<double>(names.size()) / elapsed.count() << " mazes/s)" << std::endl;
+    return solved == names.size() ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+// Random maze generator for stress tests and solver fuzzing.
+//
+// Usage: maze_gen [--count N] [--size WxH] [--perfect] [--extra P] [--no-rules]
+//                 [--check] [--seed S] [--threads T] [--out DIR] [--corpus FILE]
+//
+// Generates N mazes on T threads. --out writes one mms "map" file per maze,
+// --corpus one binary corpus for corpus_bench --corpus; with neither, only
+// the generation throughput is measured. --check runs every maze through
+// check_rules() and counts the ones breaking a rule. Each thread seeds its
+// generator with S plus the index of its first maze, so a run is
+// reproducible for a given thread count.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maze_corpus.hpp"
+#include "maze_generator.hpp"
+
+namespace {
+
+void usage() {
+    std::cerr << "usage: maze_gen [--count N] [--size WxH] [--perfect] [--extra P] [--no-rules]\n"
+                 "                [--check] [--seed S] [--threads T] [--out DIR] [--corpus FILE]"
+              << std::endl;
+}
+
+std::string maze_name(std::size_t index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "gen%07zu.txt", index);
+    return name;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::size_t count = 1000;
+    std::uint64_t seed = 1;
+    unsigned threads = std::max(1U, std::thread::hardware_concurrency());
+    std::string out;
+    std::string corpus;
+    bool check = false;
+    micro_mouse::MazeGenerator::Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (option == "--count" && has_value) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (option == "--size" && has_value) {
+            const std::string size = argv[++i];
+            options.width = std::atoi(size.c_str());
+            const auto x = size.find('x');
+            options.height = x == std::string::npos ? options.width : std::atoi(size.c_str() + x + 1);
+        } else if (option == "--perfect") {
+            options.perfect = true;
+        } else if (option == "--extra" && has_value) {
+            options.extra_openings = std::strtod(argv[++i], nullptr);
+        } else if (option == "--no-rules") {
+            options.enforce_rules = false;
+        } else if (option == "--check") {
+            check = true;
+        } else if (option == "--seed" && has_value) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (option == "--threads" && has_value) {
+            threads = static_cast<unsigned>(std::max(1L, std::strtol(argv[++i], nullptr, 10)));
+        } else if (option == "--out" && has_value) {
+            out = argv[++i];
+        } else if (option == "--corpus" && has_value) {
+            corpus = argv[++i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!out.empty()) {
+        std::filesystem::create_directories(out);
+    }
+
+    // every thread generates a contiguous range of mazes
+    threads = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, count)));
+    std::vector<micro_mouse::MazeSimulator> mazes(corpus.empty() ? 0 : count);
+    std::atomic<bool> failed{false};
+    std::atomic<std::size_t> broken{0};
+    auto worker = [&](unsigned thread) {
+        const std::size_t begin = count * thread / threads;
+        const std::size_t end = count * (thread + 1) / threads;
+        micro_mouse::MazeGenerator generator(seed + begin);
+        try {
+            for (std::size_t i = begin; i < end; ++i) {
+                micro_mouse::MazeSimulator maze = generator.generate(options);
+                if (check) {
+                    const micro_mouse::RuleCheck rules = micro_mouse::check_rules(maze);
+                    // a wall follower solves every perfect maze
+                    if (!(rules.enclosed && rules.start_walls && rules.hollow_center && rules.single_entrance &&
+                          (rules.not_wall_followable || options.perfect || !options.enforce_rules))) {
+                        ++broken;
+                    }
+                }
+                if (!out.empty()) {
+                    std::ofstream file(std::filesystem::path(out) / maze_name(i), std::ios::binary);
+                    file << maze.to_text();
+                }
+                if (!corpus.empty()) {
+                    mazes[i] = std::move(maze);
+                }
+            }
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            failed = true;
+        }
+    };
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (failed) {
+        return 1;
+    }
+
+    if (!corpus.empty()) {
+        std::vector<std::string> names(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            names[i] = maze_name(i);
+        }
+        try {
+            micro_mouse::MazeCorpus::write(corpus, names, mazes);
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    const double rate = static_cast<double>(count) / elapsed.count();
+    std::cerr << count << ' ' << options.width << 'x' << options.height << (options.perfect ? " perfect" : " multi-path")
+              << " mazes on " << threads << " threads in " << elapsed.count() << " s (" << rate << " mazes/s, "
+              << rate * 60.0 / 1e6 << " M/min)" << std::endl;
+    if (check) {
+        std::cerr << broken << " mazes break a rule" << std::endl;
+    }
+    return broken == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// Packs maze files into a binary corpus that later runs map in one call.
+//
+// Usage: maze_pack <corpus-file> <maze-file-or-directory>...
+//
+// Reports the time spent parsing the text files and the time needed to map
+// the written corpus and unpack every maze from it.
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "maze_corpus.hpp"
+#include "maze_simulator.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cerr << "usage: maze_pack <corpus-file> <maze-file-or-directory>..." << std::endl;
+        return 1;
+    }
+    std::vector<std::string> files;
+    for (int i = 2; i < argc; ++i) {
+        if (std::filesystem::is_directory(argv[i])) {
+            std::vector<std::string> entries;
+            for (const auto &entry : std::filesystem::directory_iterator(argv[i])) {
+                if (entry.is_regular_file()) {
+                    entries.push_back(entry.path().string());
+                }
+            }
+            std::sort(entries.begin(), entries.end());
+            files.insert(files.end(), entries.begin(), entries.end());
+        } else {
+            files.emplace_back(argv[i]);
+        }
+    }
+
+    std::vector<std::string> names;
+    std::vector<micro_mouse::MazeSimulator> mazes;
+    auto start = Clock::now();
+    for (const auto &file : files) {
+        try {
+            mazes.push_back(micro_mouse::MazeSimulator::from_file(file));
+            names.push_back(std::filesystem::path(file).filename().string());
+        } catch (const std::exception &e) {
+            std::cerr << file << ": " << e.what() << std::endl;
+        }
+    }
+    const double parse_ms = milliseconds(Clock::now() - start);
+
+    try {
+        micro_mouse::MazeCorpus::write(argv[1], names, mazes);
+        start = Clock::now();
+        const micro_mouse::MazeCorpus corpus(argv[1]);
+        std::uint64_t walls = 0;
+        for (std::size_t i = 0; i < corpus.size(); ++i) {
+            // keep the unpacking from being optimized away
+            walls += corpus.load(i).has_wall(0, 0, micro_mouse::Direction::EAST) ? 1 : 0;
+        }
+        const double load_ms = milliseconds(Clock::now() - start);
+        std::cout << mazes.size() << " mazes packed into " << argv[1] << " ("
+                  << std::filesystem::file_size(argv[1]) << " bytes)\n"
+                  << "parse text files: " << parse_ms << " ms\n"
+                  << "map and unpack corpus: " << load_ms << " ms (" << walls << " start cells closed east)"
+                  << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Compares the incremental planner against a full flood fill recompute over a
+// corpus of maze files. Each maze is explored once with the flood-fill policy;
+// after every observation both planners update and must agree.
+//
+// Usage: planner_compare <maze-file-or-directory>...
+//
+// Prints one CSV line per maze: cells examined and time spent by each planner.
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "flood_fill.hpp"
+#include "incremental_planner.hpp"
+#include "maze_map.hpp"
+#include "maze_simulator.hpp"
+
+namespace {
+
+struct Result {
+    std::uint64_t steps{0};
+    std::uint64_t walls{0};
+    std::uint64_t full_touched{0};
+    std::uint64_t incremental_touched{0};
+    double full_us{0.0};
+    double incremental_us{0.0};
+    bool agree{true};
+};
+
+using Clock = std::chrono::steady_clock;
+
+double microseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+Result compare(micro_mouse::MazeSimulator &maze) {
+    using micro_mouse::Direction;
+    Result result;
+    const int goal_x = maze.get_width() / 2;
+    const int goal_y = maze.get_height() / 2;
+    micro_mouse::MazeMap map(maze.get_width(), maze.get_height());
+    micro_mouse::FloodFillPlanner full;
+    micro_mouse::IncrementalPlanner incremental;
+
+    auto start = Clock::now();
+    incremental.reset(map, {map.index(goal_x, goal_y)});
+    result.incremental_us += microseconds(Clock::now() - start);
+    result.incremental_touched += incremental.get_last_touched();
+
+    const std::uint64_t max_steps = 16ULL * static_cast<std::uint64_t>(map.get_cell_count());
+    while (result.steps < max_steps) {
+        const auto &pose = maze.get_pose();
+        if (pose.x == goal_x && pose.y == goal_y) {
+            break;
+        }
+        const Direction sides[] = {micro_mouse::turn_left(pose.heading), pose.heading, micro_mouse::turn_right(pose.heading)};
+        const bool walls[] = {maze.wall_left(), maze.wall_front(), maze.wall_right()};
+        for (int i = 0; i < 3; ++i) {
+            if (map.set_wall(pose.x, pose.y, sides[i], walls[i]) && walls[i]) {
+                ++result.walls;
+                start = Clock::now();
+                incremental.wall_added(map, pose.x, pose.y, sides[i]);
+                result.incremental_us += microseconds(Clock::now() - start);
+                result.incremental_touched += incremental.get_last_touched();
+            }
+        }
+        start = Clock::now();
+        full.compute(map, goal_x, goal_y);
+        result.full_us += microseconds(Clock::now() - start);
+        result.full_touched += static_cast<std::uint64_t>(map.get_cell_count());
+
+        const auto &distances = full.get_distances();
+        for (std::size_t cell = 0; cell < distances.size(); ++cell) {
+            const int expected = distances[cell] == micro_mouse::FloodFillPlanner::kUnreachable
+                                     ? micro_mouse::IncrementalPlanner::kUnreachable
+                                     : distances[cell];
+            result.agree = result.agree && incremental.get_distances()[cell] == expected;
+        }
+
+        Direction direction = pose.heading;
+        if (!full.next_direction(map, pose, direction)) {
+            break;
+        }
+        while (maze.get_pose().heading != direction) {
+            maze.turn_right();
+        }
+        maze.move_forward();
+        ++result.steps;
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        if (std::filesystem::is_directory(argv[i])) {
+            for (const auto &entry : std::filesystem::directory_iterator(argv[i])) {
+                if (entry.is_regular_file()) {
+                    files.push_back(entry.path().string());
+                }
+            }
+        } else {
+            files.emplace_back(argv[i]);
+        }
+    }
+    if (files.empty()) {
+        std::cerr << "usage: planner_compare <maze-file-or-directory>..." << std::endl;
+        return 1;
+    }
+
+    Result total;
+    bool all_agree = true;
+    std::cout << "maze,steps,walls_added,full_touched,incremental_touched,full_us,incremental_us\n";
+    for (const auto &file : files) {
+        micro_mouse::MazeSimulator maze;
+        try {
+            maze = micro_mouse::MazeSimulator::from_file(file);
+        } catch (const std::exception &e) {
+            std::cerr << file << ": " << e.what() << std::endl;
+            continue;
+        }
+        const Result result = compare(maze);
+        std::cout << std::filesystem::path(file).filename().string() << ',' << result.steps << ',' << result.walls << ','
+                  << result.full_touched << ',' << result.incremental_touched << ',' << result.full_us << ','
+                  << result.incremental_us << '\n';
+        if (!result.agree) {
+            std::cerr << file << ": planners disagree" << std::endl;
+            all_agree = false;
+        }
+        total.steps += result.steps;
+        total.walls += result.walls;
+        total.full_touched += result.full_touched;
+        total.incremental_touched += result.incremental_touched;
+        total.full_us += result.full_us;
+        total.incremental_us += result.incremental_us;
+    }
+    std::cout << "TOTAL," << total.steps << ',' << total.walls << ',' << total.full_touched << ','
+              << total.incremental_touched << ',' << total.full_us << ',' << total.incremental_us << std::endl;
+    return all_agree ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// Microbenchmark of reply parsing: std::cin-style extraction into a fresh
+// std::string (the original MazeControlAPI code) against ReplyReader.
+//
+// Usage: reply_parser_bench [replies]
+//
+// Both readers consume the same temporary file of simulator replies, so the
+// difference is the parsing cost alone.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "reply_reader.hpp"
+
+namespace {
+
+// The reply mix of a wall follower: three wall queries and one ack per step,
+// plus the occasional maze size
+const char *const kReplies[] = {"true", "false", "false", "ack", "true", "ack", "16", "false"};
+constexpr std::size_t kReplyKinds = sizeof(kReplies) / sizeof(kReplies[0]);
+
+long checksum_stream(const std::string &path, std::size_t count) {
+    std::ifstream in(path);
+    long sum = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string response;
+        in >> response;
+        const char *expected = kReplies[i % kReplyKinds];
+        if (expected[0] >= '0' && expected[0] <= '9') {
+            sum += atoi(response.c_str());
+        } else {
+            sum += response == "true" ? 1 : 0;
+        }
+    }
+    return sum;
+}
+
+long checksum_reader(const std::string &path, std::size_t count) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    micro_mouse::ReplyReader reader(fd);
+    long sum = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const char *expected = kReplies[i % kReplyKinds];
+        if (expected[0] >= '0' && expected[0] <= '9') {
+            sum += reader.read_int();
+        } else {
+            sum += reader.read_bool() ? 1 : 0;
+        }
+    }
+    close(fd);
+    return sum;
+}
+
+template <typename Function>
+double time_ns_per_reply(Function function, std::size_t count, long &sum) {
+    const auto start = std::chrono::steady_clock::now();
+    sum = function();
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(count);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+
+    char path[] = "/tmp/reply_parser_benchXXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        std::perror("mkstemp");
+        return 1;
+    }
+    {
+        std::string content;
+        for (std::size_t i = 0; i < count; ++i) {
+            content += kReplies[i % kReplyKinds];
+            content += '\n';
+        }
+        if (write(fd, content.data(), content.size()) != static_cast<ssize_t>(content.size())) {
+            std::perror("write");
+            return 1;
+        }
+        close(fd);
+    }
+
+    long stream_sum = 0;
+    long reader_sum = 0;
+    // warm the page cache, then measure
+    checksum_reader(path, count);
+    const double stream_ns = time_ns_per_reply([&] { return checksum_stream(path, count); }, count, stream_sum);
+    const double reader_ns = time_ns_per_reply([&] { return checksum_reader(path, count); }, count, reader_sum);
+    unlink(path);
+
+    std::cout << "replies:         " << count << '\n'
+              << "std::string >> : " << stream_ns << " ns/reply\n"
+              << "ReplyReader    : " << reader_ns << " ns/reply\n"
+              << "speedup        : " << stream_ns / reader_ns << "x\n";
+    if (stream_sum != reader_sum) {
+        std::cerr << "checksum mismatch: " << stream_sum << " != " << reader_sum << std::endl;
+        return 1;
+    }
+    return 0;
+}
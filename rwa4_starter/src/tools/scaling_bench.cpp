@@ -0,0 +1,170 @@
+// Scaling of the distance field with the maze size, on fully known random
+// mazes generated in memory.
+//
+// Usage: scaling_bench [--sizes 16,64,256,512,1024] [--threads 1,2,4,8] [--tile T]
+//                      [--window D] [--perfect] [--seed S]
+//
+// For each size, times one compute() towards the four center cells with
+// FloodFillPlanner (the Bitboard256 wavefront at 16x16, the queue BFS above),
+// ClassicFloodFillPlanner at 16x16, and TiledFloodFillPlanner on each thread
+// count, then checks that the tiled field matches FloodFillPlanner. Prints
+// one CSV line per planner; speedup is against FloodFillPlanner.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "flood_fill.hpp"
+#include "maze_generator.hpp"
+#include "maze_map.hpp"
+#include "tiled_flood_fill.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<int> parse_list(const std::string &text) {
+    std::vector<int> values;
+    std::istringstream in(text);
+    for (std::string item; std::getline(in, item, ',');) {
+        values.push_back(std::atoi(item.c_str()));
+    }
+    return values;
+}
+
+// Mean seconds per call of compute(), repeated for at least 0.2 s
+template <typename Compute>
+double time_per_call(Compute compute) {
+    compute();
+    int calls = 0;
+    const auto start = Clock::now();
+    std::chrono::duration<double> elapsed{0.0};
+    do {
+        compute();
+        ++calls;
+        elapsed = Clock::now() - start;
+    } while (elapsed.count() < 0.2);
+    return elapsed.count() / calls;
+}
+
+template <typename Map>
+Map known_map(const micro_mouse::MazeSimulator &maze) {
+    Map map(maze.get_width(), maze.get_height());
+    for (int y = 0; y < maze.get_height(); ++y) {
+        for (int x = 0; x < maze.get_width(); ++x) {
+            map.set_wall(x, y, micro_mouse::Direction::EAST, maze.has_wall(x, y, micro_mouse::Direction::EAST));
+            map.set_wall(x, y, micro_mouse::Direction::NORTH, maze.has_wall(x, y, micro_mouse::Direction::NORTH));
+        }
+    }
+    return map;
+}
+
+void report(int size, const std::string &planner, unsigned threads, double seconds, double baseline) {
+    const double cells = static_cast<double>(size) * size;
+    std::cout << size << 'x' << size << ',' << planner << ',' << threads << ',' << seconds * 1e3 << ','
+              << cells / seconds / 1e6 << ',' << baseline / seconds << '\n';
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::vector<int> sizes{16, 64, 256, 512, 1024};
+    std::vector<int> threads{1, 2, 4, 8};
+    int tile = 64;
+    long window = -1;
+    std::uint64_t seed = 1;
+    micro_mouse::MazeGenerator::Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (option == "--sizes" && has_value) {
+            sizes = parse_list(argv[++i]);
+        } else if (option == "--threads" && has_value) {
+            threads = parse_list(argv[++i]);
+        } else if (option == "--tile" && has_value) {
+            tile = std::atoi(argv[++i]);
+        } else if (option == "--window" && has_value) {
+            window = std::atol(argv[++i]);
+        } else if (option == "--perfect") {
+            options.perfect = true;
+        } else if (option == "--seed" && has_value) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "usage: scaling_bench [--sizes 16,64,256,512,1024] [--threads 1,2,4,8] [--tile T]\n"
+                         "                     [--window D] [--perfect] [--seed S]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    bool agree = true;
+    std::cout << "size,planner,threads,ms,mcells_per_s,speedup\n";
+    try {
+        micro_mouse::MazeGenerator generator(seed);
+        for (const int size : sizes) {
+            options.width = size;
+            options.height = size;
+            const micro_mouse::MazeSimulator maze = generator.generate(options);
+            const auto map = known_map<micro_mouse::MazeMap>(maze);
+            const int low = (size - 1) / 2;
+            const int high = size / 2;
+            const std::vector<micro_mouse::Cell> goals{{low, low}, {low, high}, {high, low}, {high, high}};
+
+            micro_mouse::FloodFillPlanner flood;
+            const double baseline = time_per_call([&]() { flood.compute(map, goals); });
+            report(size, "flood_fill", 1, baseline, baseline);
+            if (size == micro_mouse::kClassicSize) {
+                const auto classic_map = known_map<micro_mouse::ClassicMazeMap>(maze);
+                micro_mouse::ClassicFloodFillPlanner classic;
+                report(size, "classic_flood_fill", 1, time_per_call([&]() { classic.compute(classic_map, goals); }),
+                       baseline);
+            }
+
+            const std::vector<std::uint16_t> &expected = flood.get_distances();
+            for (const int count : threads) {
+                micro_mouse::TiledFloodFillPlanner tiled(tile, static_cast<unsigned>(std::max(count, 1)));
+                if (window >= 0) {
+                    tiled.set_window(static_cast<std::uint32_t>(window));
+                }
+                const double seconds = time_per_call([&]() { tiled.compute(map, goals); });
+                report(size, "tiled", tiled.get_threads(), seconds, baseline);
+
+                // FloodFillPlanner distances are 16 bits wide; the field of
+                // each center goal is at most 2 more than the nearest one
+                const std::vector<std::uint32_t> &distances = tiled.get_distances();
+                std::uint32_t longest = 0;
+                for (const std::uint32_t distance : distances) {
+                    if (distance != micro_mouse::TiledFloodFillPlanner::kUnreachable) {
+                        longest = std::max(longest, distance);
+                    }
+                }
+                if (longest + 2 >= micro_mouse::FloodFillPlanner::kUnreachable) {
+                    std::cerr << size << 'x' << size << ": paths of " << longest
+                              << " cells overflow FloodFillPlanner, not compared" << std::endl;
+                } else {
+                    for (std::size_t cell = 0; cell < distances.size(); ++cell) {
+                        const std::uint32_t wanted = expected[cell] == micro_mouse::FloodFillPlanner::kUnreachable
+                                                         ? micro_mouse::TiledFloodFillPlanner::kUnreachable
+                                                         : expected[cell];
+                        agree = agree && distances[cell] == wanted;
+                    }
+                }
+                std::cerr << size << 'x' << size << " tiled on " << tiled.get_threads()
+                          << " threads: " << tiled.get_stats().rounds << " rounds, " << tiled.get_stats().tile_passes
+                          << " tile passes, " << tiled.get_stats().expansions << " cells expanded" << std::endl;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (!agree) {
+        std::cerr << "tiled distances differ from FloodFillPlanner" << std::endl;
+        return 1;
+    }
+    return 0;
+}
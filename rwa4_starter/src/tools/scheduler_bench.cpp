@@ -0,0 +1,170 @@
+// Runs one resumable MouseController per maze, all multiplexed on the calling
+// thread by a MouseScheduler, each against its own in-process simulator.
+//
+// Usage: scheduler_bench [--corpus FILE] [--generate N] [--size WxH] [--seed S]
+//                        [--verify] [<maze-file-or-directory>...]
+//
+// Every mouse explores to the center and back to the start. Prints the totals
+// over the mice and the throughput. --verify runs the serial explorer through
+// MazeControlAPI on each maze again and checks that both take the same
+// route: same moves, turns, wall queries and simulator commands.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "direct_backend.hpp"
+#include "explorer.hpp"
+#include "maze_api.hpp"
+#include "maze_corpus.hpp"
+#include "maze_generator.hpp"
+#include "maze_simulator.hpp"
+#include "mouse_controller.hpp"
+#include "mouse_scheduler.hpp"
+
+namespace {
+
+struct Mouse {
+    std::unique_ptr<micro_mouse::MazeSimulator> maze;
+    std::unique_ptr<micro_mouse::DirectBackend> backend;
+    std::unique_ptr<micro_mouse::MouseController> controller;
+};
+
+// The same maze through the blocking explorer; false if the routes differ
+bool matches(const micro_mouse::MazeSimulator &original, const Mouse &mouse) {
+    micro_mouse::MazeSimulator maze = original;
+    micro_mouse::DirectBackend backend(maze);
+    micro_mouse::MazeControlAPI::set_backend(&backend);
+    micro_mouse::Explorer explorer(maze.get_width(), maze.get_height());
+    if (explorer.explore()) {
+        explorer.set_goals({{0, 0}});
+        explorer.explore();
+    }
+    micro_mouse::MazeControlAPI::set_backend(nullptr);
+    const micro_mouse::MouseController &controller = *mouse.controller;
+    const auto &stats = explorer.get_stats();
+    return stats.moves == controller.get_moves() && stats.turns == controller.get_turns() &&
+           stats.wall_queries == controller.get_wall_queries() &&
+           maze.get_stats().commands == mouse.maze->get_stats().commands &&
+           explorer.get_pose().x == controller.get_pose().x && explorer.get_pose().y == controller.get_pose().y;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> files;
+    std::string corpus_path;
+    std::size_t generate = 0;
+    micro_mouse::MazeGenerator::Options options;
+    std::uint64_t seed = 1;
+    bool verify = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--corpus" && i + 1 < argc) {
+            corpus_path = argv[++i];
+        } else if (option == "--generate" && i + 1 < argc) {
+            generate = std::strtoull(argv[++i], nullptr, 10);
+        } else if (option == "--size" && i + 1 < argc) {
+            const std::string size = argv[++i];
+            options.width = std::atoi(size.c_str());
+            const std::size_t x = size.find('x');
+            options.height = x == std::string::npos ? options.width : std::atoi(size.c_str() + x + 1);
+        } else if (option == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (option == "--verify") {
+            verify = true;
+        } else if (std::filesystem::is_directory(option)) {
+            std::vector<std::string> entries;
+            for (const auto &entry : std::filesystem::directory_iterator(option)) {
+                if (entry.is_regular_file()) {
+                    entries.push_back(entry.path().string());
+                }
+            }
+            // directory order is unspecified, keep the output reproducible
+            std::sort(entries.begin(), entries.end());
+            files.insert(files.end(), entries.begin(), entries.end());
+        } else {
+            files.push_back(option);
+        }
+    }
+
+    std::vector<micro_mouse::MazeSimulator> mazes;
+    try {
+        for (const auto &file : files) {
+            mazes.push_back(micro_mouse::MazeSimulator::from_file(file));
+        }
+        if (!corpus_path.empty()) {
+            const micro_mouse::MazeCorpus corpus(corpus_path);
+            for (std::size_t i = 0; i < corpus.size(); ++i) {
+                mazes.push_back(corpus.load(i));
+            }
+        }
+        micro_mouse::MazeGenerator generator(seed);
+        for (std::size_t i = 0; i < generate; ++i) {
+            mazes.push_back(generator.generate(options));
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (mazes.empty()) {
+        std::cerr << "usage: scheduler_bench [--corpus FILE] [--generate N] [--size WxH] [--seed S]\n"
+                     "                       [--verify] [<maze-file-or-directory>...]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::vector<Mouse> mice(mazes.size());
+    micro_mouse::MouseScheduler scheduler;
+    for (std::size_t i = 0; i < mazes.size(); ++i) {
+        Mouse &mouse = mice[i];
+        mouse.maze = std::make_unique<micro_mouse::MazeSimulator>(mazes[i]);
+        mouse.backend = std::make_unique<micro_mouse::DirectBackend>(*mouse.maze);
+        mouse.controller = std::make_unique<micro_mouse::MouseController>(mazes[i].get_width(), mazes[i].get_height());
+        scheduler.add(*mouse.controller, *mouse.backend);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        scheduler.run();
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::size_t done = 0;
+    std::uint64_t moves = 0;
+    std::uint64_t turns = 0;
+    std::uint64_t queries = 0;
+    for (const Mouse &mouse : mice) {
+        done += mouse.controller->get_phase() == micro_mouse::MouseController::Phase::DONE ? 1 : 0;
+        moves += mouse.controller->get_moves();
+        turns += mouse.controller->get_turns();
+        queries += mouse.controller->get_wall_queries();
+    }
+    std::cout << "mice,done,rounds,moves,turns,wall_queries\n"
+              << mice.size() << ',' << done << ',' << scheduler.get_rounds() << ',' << moves << ',' << turns << ','
+              << queries << std::endl;
+    std::cerr << mice.size() << " mice on one thread: " << scheduler.get_steps() << " steps in " << elapsed.count()
+              << " s (" << static_cast<double>(scheduler.get_steps()) / elapsed.count() << " steps/s)" << std::endl;
+
+    if (verify) {
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < mice.size(); ++i) {
+            if (!matches(mazes[i], mice[i])) {
+                std::cerr << "mouse " << i << " differs from the explorer" << std::endl;
+                ++mismatches;
+            }
+        }
+        std::cerr << "verify: " << mice.size() - mismatches << '/' << mice.size() << " mice match" << std::endl;
+        if (mismatches != 0) {
+            return 1;
+        }
+    }
+    return done == mice.size() ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// Headless replacement for the mms GUI: runs a solver executable as a child
+// process and answers its MazeControlAPI commands from a maze file.
+//
+// Usage: rwa4_sim [--episodes N] [--max-steps N] <maze-file> <solver> [args...]
+//
+// An episode ends when the mouse enters a center cell. The simulator then
+// raises the reset flag, and the next episode starts when the solver calls
+// ack_reset(). The run stops after N episodes, after N move commands, or when
+// the solver exits.
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "maze_simulator.hpp"
+
+namespace {
+
+void usage() {
+    std::cerr << "usage: rwa4_sim [--episodes N] [--max-steps N] <maze-file> <solver> [args...]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::uint64_t episodes = 1;
+    std::uint64_t max_steps = 1000000;
+    int arg = 1;
+    for (; arg < argc; ++arg) {
+        const std::string option = argv[arg];
+        if (option == "--episodes" && arg + 1 < argc) {
+            episodes = std::strtoull(argv[++arg], nullptr, 10);
+        } else if (option == "--max-steps" && arg + 1 < argc) {
+            max_steps = std::strtoull(argv[++arg], nullptr, 10);
+        } else {
+            break;
+        }
+    }
+    if (argc - arg < 2) {
+        usage();
+        return 1;
+    }
+
+    micro_mouse::MazeSimulator maze;
+    try {
+        maze = micro_mouse::MazeSimulator::from_file(argv[arg]);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // to_solver carries replies, from_solver carries commands
+    int to_solver[2];
+    int from_solver[2];
+    if (pipe(to_solver) != 0 || pipe(from_solver) != 0) {
+        std::perror("pipe");
+        return 1;
+    }
+    const pid_t child = fork();
+    if (child < 0) {
+        std::perror("fork");
+        return 1;
+    }
+    if (child == 0) {
+        dup2(to_solver[0], STDIN_FILENO);
+        dup2(from_solver[1], STDOUT_FILENO);
+        close(to_solver[0]);
+        close(to_solver[1]);
+        close(from_solver[0]);
+        close(from_solver[1]);
+        execvp(argv[arg + 1], argv + arg + 1);
+        std::perror("execvp");
+        _exit(127);
+    }
+    close(to_solver[0]);
+    close(from_solver[1]);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    FILE *commands = fdopen(from_solver[0], "r");
+    FILE *replies = fdopen(to_solver[1], "w");
+    char *line = nullptr;
+    std::size_t capacity = 0;
+    std::string reply;
+    const auto start = std::chrono::steady_clock::now();
+
+    while (maze.get_stats().moves < max_steps && maze.get_stats().episodes < episodes) {
+        ssize_t length = getline(&line, &capacity, commands);
+        if (length < 0) {
+            break;
+        }
+        if (length > 0 && line[length - 1] == '\n') {
+            --length;
+        }
+        if (maze.handle(std::string_view(line, static_cast<std::size_t>(length)), reply)) {
+            reply.push_back('\n');
+            // replies are flushed immediately: the solver blocks on them
+            if (std::fwrite(reply.data(), 1, reply.size(), replies) != reply.size() || std::fflush(replies) != 0) {
+                break;
+            }
+        }
+        const auto &pose = maze.get_pose();
+        if (!maze.was_reset() && maze.is_goal(pose.x, pose.y)) {
+            maze.request_reset();
+        }
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::free(line);
+    std::fclose(replies);
+    std::fclose(commands);
+    kill(child, SIGTERM);
+    waitpid(child, nullptr, 0);
+
+    const auto &stats = maze.get_stats();
+    std::cerr << "episodes:     " << stats.episodes << '\n'
+              << "commands:     " << stats.commands << '\n'
+              << "wall queries: " << stats.wall_queries << '\n'
+              << "moves:        " << stats.moves << " (" << stats.cells_moved << " cells)\n"
+              << "turns:        " << stats.turns << '\n'
+              << "crashes:      " << stats.crashes << '\n'
+              << "elapsed:      " << elapsed.count() << " s ("
+              << static_cast<double>(stats.commands) / elapsed.count() << " commands/s)" << std::endl;
+    return 0;
+}
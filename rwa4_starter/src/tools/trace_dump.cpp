@@ -0,0 +1,111 @@
+// Prints a trace written by rwa4_cpp --record, one command per line.
+//
+// Usage: trace_dump [--summary] <trace-file>
+//
+// Each line holds the record index, the command, its arguments and its
+// reply after "->". --summary prints only the count of each command.
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "trace.hpp"
+
+namespace {
+
+using micro_mouse::TraceOp;
+
+void print(std::uint64_t index, const micro_mouse::TraceRecord &record) {
+    std::cout << index << ' ' << micro_mouse::trace_op_name(record.op);
+    switch (record.op) {
+    case TraceOp::MAZE_WIDTH:
+    case TraceOp::MAZE_HEIGHT:
+        std::cout << " -> " << record.values[0];
+        break;
+    case TraceOp::WALL_FRONT:
+    case TraceOp::WALL_RIGHT:
+    case TraceOp::WALL_LEFT:
+    case TraceOp::WAS_RESET:
+        std::cout << " -> " << (record.flag ? "true" : "false");
+        break;
+    case TraceOp::MOVE_FORWARD:
+        std::cout << ' ' << record.values[0];
+        break;
+    case TraceOp::SET_WALL:
+    case TraceOp::CLEAR_WALL:
+    case TraceOp::SET_COLOR:
+        std::cout << ' ' << record.values[0] << ' ' << record.values[1] << ' ' << static_cast<char>(record.values[2]);
+        break;
+    case TraceOp::CLEAR_COLOR:
+    case TraceOp::CLEAR_TEXT:
+        std::cout << ' ' << record.values[0] << ' ' << record.values[1];
+        break;
+    case TraceOp::SET_TEXT:
+        std::cout << ' ' << record.values[0] << ' ' << record.values[1] << ' ' << record.text;
+        break;
+    case TraceOp::SET_BUFFERED:
+        std::cout << ' ' << (record.flag ? "true" : "false");
+        break;
+    case TraceOp::POST_STEP:
+        std::cout << " turns=" << record.values[0] << " distance=" << record.values[1] << " sense=" << record.values[2]
+                  << (record.flag ? " check_reset" : "");
+        break;
+    case TraceOp::WAIT_STEP: {
+        const std::int64_t readings = record.values[0];
+        std::cout << " -> reset=" << (readings & 1) << " left=" << ((readings >> 1) & 1)
+                  << " front=" << ((readings >> 2) & 1) << " right=" << ((readings >> 3) & 1);
+        break;
+    }
+    case TraceOp::FAILURE:
+        std::cout << ' ' << record.text;
+        break;
+    default:
+        break;
+    }
+    std::cout << '\n';
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    bool summary = false;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--summary") {
+            summary = true;
+        } else {
+            path = option;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "usage: trace_dump [--summary] <trace-file>" << std::endl;
+        return 1;
+    }
+
+    std::uint64_t counts[static_cast<int>(TraceOp::FAILURE) + 1] = {};
+    try {
+        micro_mouse::TraceReader reader(path);
+        std::cout << "seed " << reader.get_seed() << ", flags " << reader.get_flags() << ", max steps "
+                  << reader.get_max_steps() << '\n';
+        micro_mouse::TraceRecord record;
+        for (std::uint64_t index = reader.get_index(); reader.next(record); index = reader.get_index()) {
+            ++counts[static_cast<int>(record.op)];
+            if (!summary) {
+                print(index, record);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cout.flush();
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (summary) {
+        for (int op = 0; op <= static_cast<int>(TraceOp::FAILURE); ++op) {
+            if (counts[op] != 0) {
+                std::cout << micro_mouse::trace_op_name(static_cast<TraceOp>(op)) << ' ' << counts[op] << '\n';
+            }
+        }
+    }
+    return 0;
+}
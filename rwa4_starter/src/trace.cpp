@@ -0,0 +1,462 @@
+#include "trace.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+using micro_mouse::TraceOp;
+
+constexpr char kMagic[] = {'R', 'W', 'A', '4', 'T', 'R', 'C'};
+// version 1 had no step limit in the header
+constexpr std::uint8_t kVersion = 2;
+constexpr std::uint8_t kFlagBit = 0x80;
+constexpr int kOpCount = static_cast<int>(TraceOp::FAILURE) + 1;
+// buffered records are written out past this size
+constexpr std::size_t kBlockSize = 64 * 1024;
+
+// Payload layout of each op: number of values, and whether a text follows
+struct Layout {
+    std::string_view name;
+    int values;
+    bool text;
+};
+
+constexpr Layout kLayouts[kOpCount] = {
+    {"mazeWidth", 1, false},  {"mazeHeight", 1, false},   {"wallFront", 0, false},   {"wallRight", 0, false},
+    {"wallLeft", 0, false},   {"moveForward", 1, false},  {"turnRight", 0, false},   {"turnLeft", 0, false},
+    {"setWall", 3, false},    {"clearWall", 3, false},    {"setColor", 3, false},    {"clearColor", 2, false},
+    {"clearAllColor", 0, false}, {"setText", 2, true},    {"clearText", 2, false},   {"clearAllText", 0, false},
+    {"wasReset", 0, false},   {"ackReset", 0, false},     {"setBuffered", 0, false}, {"flush", 0, false},
+    {"postStep", 3, false},   {"waitStep", 1, false},     {"failure", 0, true}};
+
+const Layout &layout(TraceOp op) noexcept {
+    return kLayouts[static_cast<int>(op)];
+}
+
+void append_varint(std::string &out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+std::uint64_t zigzag(std::int64_t value) noexcept {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value) noexcept {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+// "moveForward 3" style description of a command, for error messages
+std::string describe(TraceOp op, const std::int64_t *values, std::size_t count, std::string_view text) {
+    std::string description(layout(op).name);
+    for (std::size_t i = 0; i < count; ++i) {
+        description += ' ' + std::to_string(values[i]);
+    }
+    if (!text.empty()) {
+        description += " \"" + std::string(text) + '"';
+    }
+    return description;
+}
+
+std::int64_t step_readings(const micro_mouse::StepReply &reply) noexcept {
+    return (reply.reset ? 1 : 0) | (reply.wall_left ? 2 : 0) | (reply.wall_front ? 4 : 0) |
+           (reply.wall_right ? 8 : 0);
+}
+
+} // namespace
+
+std::string_view micro_mouse::trace_op_name(TraceOp op) noexcept {
+    return static_cast<int>(op) < kOpCount ? layout(op).name : std::string_view("unknown");
+}
+
+micro_mouse::TraceReader::TraceReader(const std::string &path) : path_{path}, file_{path} {
+    if (file_.size() < sizeof(kMagic) + 1 || std::memcmp(file_.data(), kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error(path + ": not a trace");
+    }
+    if (static_cast<std::uint8_t>(file_.data()[sizeof(kMagic)]) != kVersion) {
+        throw std::runtime_error(path + ": unsupported trace version");
+    }
+    position_ = sizeof(kMagic) + 1;
+    seed_ = read_varint();
+    flags_ = read_varint();
+    max_steps_ = read_varint();
+}
+
+std::uint64_t micro_mouse::TraceReader::read_varint() {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (position_ == file_.size()) {
+            break;
+        }
+        const auto byte = static_cast<std::uint8_t>(file_.data()[position_++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error(path_ + ": truncated trace");
+}
+
+bool micro_mouse::TraceReader::next_is(TraceOp op) const noexcept {
+    return position_ < file_.size() &&
+           (static_cast<std::uint8_t>(file_.data()[position_]) & ~kFlagBit) == static_cast<std::uint8_t>(op);
+}
+
+bool micro_mouse::TraceReader::next(TraceRecord &record) {
+    if (at_end()) {
+        return false;
+    }
+    const auto byte = static_cast<std::uint8_t>(file_.data()[position_++]);
+    if ((byte & ~kFlagBit) >= kOpCount) {
+        throw std::runtime_error(path_ + ": unknown record " + std::to_string(index_));
+    }
+    record.op = static_cast<TraceOp>(byte & ~kFlagBit);
+    record.flag = (byte & kFlagBit) != 0;
+    const Layout &payload = layout(record.op);
+    for (int i = 0; i < 3; ++i) {
+        record.values[i] = i < payload.values ? unzigzag(read_varint()) : 0;
+    }
+    record.text = {};
+    if (payload.text) {
+        const std::uint64_t length = read_varint();
+        if (length > file_.size() - position_) {
+            throw std::runtime_error(path_ + ": truncated trace");
+        }
+        record.text = std::string_view(file_.data() + position_, static_cast<std::size_t>(length));
+        position_ += static_cast<std::size_t>(length);
+    }
+    ++index_;
+    return true;
+}
+
+micro_mouse::TraceRecorder::TraceRecorder(const std::string &path, MazeBackend &backend, std::uint64_t seed,
+                                          std::uint64_t flags, std::uint64_t max_steps)
+    : backend_{backend}, out_{path, std::ios::binary | std::ios::trunc} {
+    if (!out_) {
+        throw std::runtime_error("cannot write trace " + path);
+    }
+    buffer_.reserve(kBlockSize + 256);
+    buffer_.append(kMagic, sizeof(kMagic));
+    buffer_.push_back(static_cast<char>(kVersion));
+    append_varint(buffer_, seed);
+    append_varint(buffer_, flags);
+    append_varint(buffer_, max_steps);
+}
+
+micro_mouse::TraceRecorder::~TraceRecorder() {
+    write_out();
+}
+
+void micro_mouse::TraceRecorder::record(TraceOp op, bool flag, std::initializer_list<std::int64_t> values,
+                                        std::string_view text) {
+    buffer_.push_back(static_cast<char>(static_cast<std::uint8_t>(op) | (flag ? kFlagBit : 0)));
+    for (const std::int64_t value : values) {
+        append_varint(buffer_, zigzag(value));
+    }
+    if (layout(op).text) {
+        append_varint(buffer_, text.size());
+        buffer_.append(text);
+    }
+    ++records_;
+    if (buffer_.size() >= kBlockSize) {
+        write_out();
+    }
+}
+
+void micro_mouse::TraceRecorder::write_out() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    out_.flush();
+    buffer_.clear();
+}
+
+template <typename Call>
+auto micro_mouse::TraceRecorder::forward(Call call, TraceOp op, std::initializer_list<std::int64_t> values,
+                                         std::string_view text) {
+    try {
+        return call();
+    } catch (const std::exception &e) {
+        record(op, false, values, text);
+        record(TraceOp::FAILURE, false, {}, e.what());
+        write_out();
+        throw;
+    }
+}
+
+int micro_mouse::TraceRecorder::get_maze_width() {
+    const int width = forward([this]() { return backend_.get_maze_width(); }, TraceOp::MAZE_WIDTH, {0});
+    record(TraceOp::MAZE_WIDTH, false, {width});
+    return width;
+}
+
+int micro_mouse::TraceRecorder::get_maze_height() {
+    const int height = forward([this]() { return backend_.get_maze_height(); }, TraceOp::MAZE_HEIGHT, {0});
+    record(TraceOp::MAZE_HEIGHT, false, {height});
+    return height;
+}
+
+bool micro_mouse::TraceRecorder::has_wall_front() {
+    const bool wall = forward([this]() { return backend_.has_wall_front(); }, TraceOp::WALL_FRONT);
+    record(TraceOp::WALL_FRONT, wall);
+    return wall;
+}
+
+bool micro_mouse::TraceRecorder::has_wall_right() {
+    const bool wall = forward([this]() { return backend_.has_wall_right(); }, TraceOp::WALL_RIGHT);
+    record(TraceOp::WALL_RIGHT, wall);
+    return wall;
+}
+
+bool micro_mouse::TraceRecorder::has_wall_left() {
+    const bool wall = forward([this]() { return backend_.has_wall_left(); }, TraceOp::WALL_LEFT);
+    record(TraceOp::WALL_LEFT, wall);
+    return wall;
+}
+
+void micro_mouse::TraceRecorder::move_forward(int distance) {
+    forward([this, distance]() { backend_.move_forward(distance); }, TraceOp::MOVE_FORWARD, {distance});
+    record(TraceOp::MOVE_FORWARD, false, {distance});
+}
+
+void micro_mouse::TraceRecorder::turn_right() {
+    forward([this]() { backend_.turn_right(); }, TraceOp::TURN_RIGHT);
+    record(TraceOp::TURN_RIGHT);
+}
+
+void micro_mouse::TraceRecorder::turn_left() {
+    forward([this]() { backend_.turn_left(); }, TraceOp::TURN_LEFT);
+    record(TraceOp::TURN_LEFT);
+}
+
+void micro_mouse::TraceRecorder::set_wall(int x, int y, char direction) {
+    forward([&]() { backend_.set_wall(x, y, direction); }, TraceOp::SET_WALL, {x, y, direction});
+    record(TraceOp::SET_WALL, false, {x, y, direction});
+}
+
+void micro_mouse::TraceRecorder::clear_wall(int x, int y, char direction) {
+    forward([&]() { backend_.clear_wall(x, y, direction); }, TraceOp::CLEAR_WALL, {x, y, direction});
+    record(TraceOp::CLEAR_WALL, false, {x, y, direction});
+}
+
+void micro_mouse::TraceRecorder::set_color(int x, int y, char color) {
+    forward([&]() { backend_.set_color(x, y, color); }, TraceOp::SET_COLOR, {x, y, color});
+    record(TraceOp::SET_COLOR, false, {x, y, color});
+}
+
+void micro_mouse::TraceRecorder::clear_color(int x, int y) {
+    forward([&]() { backend_.clear_color(x, y); }, TraceOp::CLEAR_COLOR, {x, y});
+    record(TraceOp::CLEAR_COLOR, false, {x, y});
+}
+
+void micro_mouse::TraceRecorder::clear_all_color() {
+    forward([this]() { backend_.clear_all_color(); }, TraceOp::CLEAR_ALL_COLOR);
+    record(TraceOp::CLEAR_ALL_COLOR);
+}
+
+void micro_mouse::TraceRecorder::set_text(int x, int y, const std::string &text) {
+    forward([&]() { backend_.set_text(x, y, text); }, TraceOp::SET_TEXT, {x, y}, text);
+    record(TraceOp::SET_TEXT, false, {x, y}, text);
+}
+
+void micro_mouse::TraceRecorder::clear_text(int x, int y) {
+    forward([&]() { backend_.clear_text(x, y); }, TraceOp::CLEAR_TEXT, {x, y});
+    record(TraceOp::CLEAR_TEXT, false, {x, y});
+}
+
+void micro_mouse::TraceRecorder::clear_all_text() {
+    forward([this]() { backend_.clear_all_text(); }, TraceOp::CLEAR_ALL_TEXT);
+    record(TraceOp::CLEAR_ALL_TEXT);
+}
+
+bool micro_mouse::TraceRecorder::was_reset() {
+    const bool reset = forward([this]() { return backend_.was_reset(); }, TraceOp::WAS_RESET);
+    record(TraceOp::WAS_RESET, reset);
+    return reset;
+}
+
+void micro_mouse::TraceRecorder::ack_reset() {
+    forward([this]() { backend_.ack_reset(); }, TraceOp::ACK_RESET);
+    record(TraceOp::ACK_RESET);
+}
+
+void micro_mouse::TraceRecorder::set_buffered_visualization(bool buffered) {
+    forward([this, buffered]() { backend_.set_buffered_visualization(buffered); }, TraceOp::SET_BUFFERED);
+    record(TraceOp::SET_BUFFERED, buffered);
+}
+
+void micro_mouse::TraceRecorder::flush() {
+    forward([this]() { backend_.flush(); }, TraceOp::FLUSH);
+    record(TraceOp::FLUSH);
+    // the run may end here, keep what was recorded
+    write_out();
+}
+
+void micro_mouse::TraceRecorder::post_step(const StepCommand &step) {
+    const std::initializer_list<std::int64_t> values = {step.turns, step.distance, step.sense};
+    forward([this, &step]() { backend_.post_step(step); }, TraceOp::POST_STEP, values);
+    record(TraceOp::POST_STEP, step.check_reset, values);
+}
+
+micro_mouse::StepReply micro_mouse::TraceRecorder::wait_step() {
+    const StepReply reply = forward([this]() { return backend_.wait_step(); }, TraceOp::WAIT_STEP, {0});
+    record(TraceOp::WAIT_STEP, false, {step_readings(reply)});
+    return reply;
+}
+
+const micro_mouse::TraceRecord &micro_mouse::TraceReplayBackend::expect(TraceOp op,
+                                                                         std::initializer_list<std::int64_t> values,
+                                                                         std::string_view text) {
+    const std::uint64_t index = reader_.get_index();
+    if (!reader_.next(record_)) {
+        throw std::runtime_error("trace ends before " + describe(op, values.begin(), values.size(), text));
+    }
+    bool same = record_.op == op && record_.text == text;
+    for (std::size_t i = 0; same && i < values.size(); ++i) {
+        same = record_.values[i] == values.begin()[i];
+    }
+    if (!same) {
+        const auto count = static_cast<std::size_t>(layout(record_.op).values);
+        throw std::runtime_error("trace diverges at record " + std::to_string(index) + ": recorded " +
+                                 describe(record_.op, record_.values, count, record_.text) + ", replayed " +
+                                 describe(op, values.begin(), values.size(), text));
+    }
+    return record_;
+}
+
+void micro_mouse::TraceReplayBackend::replay_failure() {
+    if (reader_.next_is(TraceOp::FAILURE)) {
+        reader_.next(record_);
+        throw std::runtime_error(std::string(record_.text));
+    }
+}
+
+int micro_mouse::TraceReplayBackend::get_maze_width() {
+    const auto width = static_cast<int>(expect(TraceOp::MAZE_WIDTH).values[0]);
+    replay_failure();
+    return width;
+}
+
+int micro_mouse::TraceReplayBackend::get_maze_height() {
+    const auto height = static_cast<int>(expect(TraceOp::MAZE_HEIGHT).values[0]);
+    replay_failure();
+    return height;
+}
+
+bool micro_mouse::TraceReplayBackend::has_wall_front() {
+    const bool wall = expect(TraceOp::WALL_FRONT).flag;
+    replay_failure();
+    return wall;
+}
+
+bool micro_mouse::TraceReplayBackend::has_wall_right() {
+    const bool wall = expect(TraceOp::WALL_RIGHT).flag;
+    replay_failure();
+    return wall;
+}
+
+bool micro_mouse::TraceReplayBackend::has_wall_left() {
+    const bool wall = expect(TraceOp::WALL_LEFT).flag;
+    replay_failure();
+    return wall;
+}
+
+void micro_mouse::TraceReplayBackend::move_forward(int distance) {
+    expect(TraceOp::MOVE_FORWARD, {distance});
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::turn_right() {
+    expect(TraceOp::TURN_RIGHT);
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::turn_left() {
+    expect(TraceOp::TURN_LEFT);
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::set_wall(int x, int y, char direction) {
+    expect(TraceOp::SET_WALL, {x, y, direction});
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::clear_wall(int x, int y, char direction) {
+    expect(TraceOp::CLEAR_WALL, {x, y, direction});
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::set_color(int x, int y, char color) {
+    expect(TraceOp::SET_COLOR, {x, y, color});
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::clear_color(int x, int y) {
+    expect(TraceOp::CLEAR_COLOR, {x, y});
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::clear_all_color() {
+    expect(TraceOp::CLEAR_ALL_COLOR);
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::set_text(int x, int y, const std::string &text) {
+    expect(TraceOp::SET_TEXT, {x, y}, text);
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::clear_text(int x, int y) {
+    expect(TraceOp::CLEAR_TEXT, {x, y});
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::clear_all_text() {
+    expect(TraceOp::CLEAR_ALL_TEXT);
+    replay_failure();
+}
+
+bool micro_mouse::TraceReplayBackend::was_reset() {
+    const bool reset = expect(TraceOp::WAS_RESET).flag;
+    replay_failure();
+    return reset;
+}
+
+void micro_mouse::TraceReplayBackend::ack_reset() {
+    expect(TraceOp::ACK_RESET);
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::set_buffered_visualization(bool buffered) {
+    if (expect(TraceOp::SET_BUFFERED).flag != buffered) {
+        throw std::runtime_error("trace diverges at record " + std::to_string(reader_.get_index() - 1) +
+                                 ": visualization buffering differs");
+    }
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::flush() {
+    expect(TraceOp::FLUSH);
+    replay_failure();
+}
+
+void micro_mouse::TraceReplayBackend::post_step(const StepCommand &step) {
+    if (expect(TraceOp::POST_STEP, {step.turns, step.distance, step.sense}).flag != step.check_reset) {
+        throw std::runtime_error("trace diverges at record " + std::to_string(reader_.get_index() - 1) +
+                                 ": reset check differs");
+    }
+    replay_failure();
+}
+
+micro_mouse::StepReply micro_mouse::TraceReplayBackend::wait_step() {
+    const std::int64_t readings = expect(TraceOp::WAIT_STEP).values[0];
+    replay_failure();
+    StepReply reply;
+    reply.reset = (readings & 1) != 0;
+    reply.wall_left = (readings & 2) != 0;
+    reply.wall_front = (readings & 4) != 0;
+    reply.wall_right = (readings & 8) != 0;
+    return reply;
+}
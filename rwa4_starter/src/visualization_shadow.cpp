@@ -0,0 +1,170 @@
+#include "visualization_shadow.hpp"
+
+#include <algorithm>
+
+#include "maze_types.hpp"
+
+micro_mouse::VisualizationShadow::VisualizationShadow(int width, int height)
+    : width_{std::max(width, 1)}, height_{std::max(height, 1)},
+      cells_(static_cast<std::size_t>(width_) * static_cast<std::size_t>(height_)) {}
+
+micro_mouse::VisualizationShadow::Cell *micro_mouse::VisualizationShadow::cell(int x, int y) {
+    if (x < 0 || y < 0) {
+        return nullptr;
+    }
+    if (x >= width_ || y >= height_) {
+        const int width = std::max(width_, x + 1);
+        const int height = std::max(height_, y + 1);
+        std::vector<Cell> cells(static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+        for (int row = 0; row < height_; ++row) {
+            for (int column = 0; column < width_; ++column) {
+                cells[static_cast<std::size_t>(row * width + column)] =
+                    std::move(cells_[static_cast<std::size_t>(row * width_ + column)]);
+            }
+        }
+        cells_ = std::move(cells);
+        width_ = width;
+        height_ = height;
+    }
+    return &cells_[static_cast<std::size_t>(y * width_ + x)];
+}
+
+bool micro_mouse::VisualizationShadow::count(bool changed) noexcept {
+    ++(changed ? forwarded_ : suppressed_);
+    return changed;
+}
+
+bool micro_mouse::VisualizationShadow::set_color(int x, int y, char color) {
+    Cell *c = cell(x, y);
+    if (c == nullptr) {
+        return count(true);
+    }
+    if (c->color == color) {
+        return count(false);
+    }
+    if (c->color == '\0') {
+        ++colored_;
+    }
+    c->color = color;
+    return count(true);
+}
+
+bool micro_mouse::VisualizationShadow::clear_color(int x, int y) {
+    Cell *c = cell(x, y);
+    if (c == nullptr) {
+        return count(true);
+    }
+    if (c->color == '\0') {
+        return count(false);
+    }
+    c->color = '\0';
+    --colored_;
+    return count(true);
+}
+
+bool micro_mouse::VisualizationShadow::clear_all_color() {
+    if (colored_ == 0) {
+        return count(false);
+    }
+    for (auto &c : cells_) {
+        c.color = '\0';
+    }
+    colored_ = 0;
+    return count(true);
+}
+
+bool micro_mouse::VisualizationShadow::set_text(int x, int y, const std::string &text) {
+    Cell *c = cell(x, y);
+    if (c == nullptr) {
+        return count(true);
+    }
+    if (c->has_text && c->text == text) {
+        return count(false);
+    }
+    if (!c->has_text) {
+        ++texts_;
+    }
+    c->has_text = true;
+    c->text = text;
+    return count(true);
+}
+
+bool micro_mouse::VisualizationShadow::clear_text(int x, int y) {
+    Cell *c = cell(x, y);
+    if (c == nullptr) {
+        return count(true);
+    }
+    if (!c->has_text) {
+        return count(false);
+    }
+    c->has_text = false;
+    c->text.clear();
+    --texts_;
+    return count(true);
+}
+
+bool micro_mouse::VisualizationShadow::clear_all_text() {
+    if (texts_ == 0) {
+        return count(false);
+    }
+    for (auto &c : cells_) {
+        c.has_text = false;
+        c.text.clear();
+    }
+    texts_ = 0;
+    return count(true);
+}
+
+micro_mouse::VisualizationShadow::Cell *micro_mouse::VisualizationShadow::wall_cell(int x, int y, char direction,
+                                                                                      std::uint8_t &mask) {
+    Direction d{};
+    if (!from_char(direction, d)) {
+        return nullptr;
+    }
+    // a wall is one edge shared by two cells, as in mms: the west and south
+    // walls are kept as the east and north walls of the neighbour, so that
+    // only the outer boundary uses them
+    if (d == Direction::WEST && x > 0) {
+        --x;
+        d = Direction::EAST;
+    } else if (d == Direction::SOUTH && y > 0) {
+        --y;
+        d = Direction::NORTH;
+    }
+    mask = static_cast<std::uint8_t>(1U << static_cast<int>(d));
+    return cell(x, y);
+}
+
+bool micro_mouse::VisualizationShadow::set_wall(int x, int y, char direction) {
+    std::uint8_t mask = 0;
+    Cell *c = wall_cell(x, y, direction, mask);
+    if (c == nullptr) {
+        return count(true);
+    }
+    if ((c->walls & mask) != 0) {
+        return count(false);
+    }
+    c->walls = static_cast<std::uint8_t>(c->walls | mask);
+    return count(true);
+}
+
+bool micro_mouse::VisualizationShadow::clear_wall(int x, int y, char direction) {
+    std::uint8_t mask = 0;
+    Cell *c = wall_cell(x, y, direction, mask);
+    if (c == nullptr) {
+        return count(true);
+    }
+    if ((c->walls & mask) == 0) {
+        return count(false);
+    }
+    c->walls = static_cast<std::uint8_t>(c->walls & ~mask);
+    return count(true);
+}
+
+void micro_mouse::VisualizationShadow::clear() {
+    for (auto &c : cells_) {
+        c = Cell{};
+    }
+    colored_ = 0;
+    texts_ = 0;
+}
@@ -0,0 +1,52 @@
+#include "wall_follower.hpp"
+
+#include <algorithm>
+
+micro_mouse::WallFollower::WallFollower(int width, int height, Hand hand)
+    : walls_{width, height},
+      hand_{hand},
+      goals_{{(width - 1) / 2, (height - 1) / 2}, {(width - 1) / 2, height / 2},
+             {width / 2, (height - 1) / 2}, {width / 2, height / 2}},
+      visited_((4 * static_cast<std::size_t>(width) * static_cast<std::size_t>(height) + 63) / 64) {}
+
+bool micro_mouse::WallFollower::at_goal() const noexcept {
+    const Pose &pose = walls_.get_pose();
+    return std::any_of(goals_.begin(), goals_.end(),
+                       [&pose](const Cell &goal) { return goal.x == pose.x && goal.y == pose.y; });
+}
+
+micro_mouse::WallFollower::Outcome micro_mouse::WallFollower::run(std::uint64_t max_moves) {
+    std::fill(visited_.begin(), visited_.end(), 0);
+    const int width = walls_.get_map().get_width();
+    for (std::uint64_t move = 0;; ++move) {
+        if (at_goal()) {
+            return Outcome::GOAL;
+        }
+        const Pose &pose = walls_.get_pose();
+        const std::size_t state = 4 * static_cast<std::size_t>(pose.y * width + pose.x) +
+                                  static_cast<std::size_t>(pose.heading);
+        const std::uint64_t bit = std::uint64_t{1} << (state & 63);
+        if ((visited_[state / 64] & bit) != 0) {
+            return Outcome::LOOP;
+        }
+        visited_[state / 64] |= bit;
+        if (move == max_moves) {
+            return Outcome::OUT_OF_MOVES;
+        }
+
+        const bool left_hand = hand_ == Hand::LEFT;
+        if (!(left_hand ? walls_.has_wall_left() : walls_.has_wall_right())) {
+            left_hand ? walls_.turn_left() : walls_.turn_right();
+        } else if (walls_.has_wall_front()) {
+            if (!(left_hand ? walls_.has_wall_right() : walls_.has_wall_left())) {
+                left_hand ? walls_.turn_right() : walls_.turn_left();
+            } else {
+                // dead end
+                walls_.turn_right();
+                walls_.turn_right();
+            }
+        }
+        walls_.move_forward();
+        ++moves_;
+    }
+}
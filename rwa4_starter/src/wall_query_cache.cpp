@@ -0,0 +1,37 @@
+#include "wall_query_cache.hpp"
+
+#include "maze_api.hpp"
+
+bool micro_mouse::WallQueryCache::has_wall(Direction side) {
+    if (map_.is_known(pose_.x, pose_.y, side)) {
+        ++stats_.answered;
+        return map_.has_wall(pose_.x, pose_.y, side);
+    }
+    bool present = false;
+    if (side == pose_.heading) {
+        present = MazeControlAPI::has_wall_front();
+    } else if (side == micro_mouse::turn_right(pose_.heading)) {
+        present = MazeControlAPI::has_wall_right();
+    } else {
+        present = MazeControlAPI::has_wall_left();
+    }
+    ++stats_.queried;
+    map_.set_wall(pose_.x, pose_.y, side, present);
+    return present;
+}
+
+void micro_mouse::WallQueryCache::move_forward(int distance) {
+    MazeControlAPI::move_forward(distance);
+    pose_.x += distance * dx(pose_.heading);
+    pose_.y += distance * dy(pose_.heading);
+}
+
+void micro_mouse::WallQueryCache::turn_right() {
+    MazeControlAPI::turn_right();
+    pose_.heading = micro_mouse::turn_right(pose_.heading);
+}
+
+void micro_mouse::WallQueryCache::turn_left() {
+    MazeControlAPI::turn_left();
+    pose_.heading = micro_mouse::turn_left(pose_.heading);
+}